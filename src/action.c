@@ -208,3 +208,33 @@ action_t *action_trigger_lookup ( const gchar *trigger )
 
   return g_hash_table_lookup(trigger_actions, trigger);
 }
+
+/* drop all functions and trigger actions ahead of a config reload */
+void action_config_clear ( void )
+{
+  GHashTableIter iter;
+  void *list, *action;
+  GList *liter;
+
+  if(functions)
+  {
+    g_hash_table_iter_init(&iter, functions);
+    while(g_hash_table_iter_next(&iter, NULL, &list))
+    {
+      for(liter=list; liter; liter=g_list_next(liter))
+        action_free(liter->data, NULL);
+      g_list_free(list);
+      g_hash_table_iter_remove(&iter);
+    }
+  }
+
+  if(trigger_actions)
+  {
+    g_hash_table_iter_init(&iter, trigger_actions);
+    while(g_hash_table_iter_next(&iter, NULL, &action))
+    {
+      action_free(action, NULL);
+      g_hash_table_iter_remove(&iter);
+    }
+  }
+}
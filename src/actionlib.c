@@ -15,6 +15,7 @@
 #include "popup.h"
 #include "client.h"
 #include "appinfo.h"
+#include "trace.h"
 
 static void exec_action ( gchar *cmd, gchar *name, void *widget,
     void *event, void *win, void *state )
@@ -530,6 +531,53 @@ static ModuleActionHandlerV1 clear_widget_handler = {
   .function = (ModuleActionFunc)clear_widget_action
 };
 
+#if METRICS
+static void profile_dump_action ( gchar *cmd, gchar *name, void *widget,
+    void *event, window_t *win, guint16 *state )
+{
+  gint count;
+
+  count = cmd? g_ascii_strtoll(cmd, NULL, 10) : 0;
+  if(count<=0)
+    count = 10;
+
+  expr_profile_dump(count);
+  scanner_profile_dump(count);
+}
+
+static ModuleActionHandlerV1 profile_dump_handler = {
+  .name = "ProfileDump",
+  .function = (ModuleActionFunc)profile_dump_action
+};
+
+static void trace_start_action ( gchar *cmd, gchar *name, void *widget,
+    void *event, window_t *win, guint16 *state )
+{
+  trace_start();
+}
+
+static ModuleActionHandlerV1 trace_start_handler = {
+  .name = "TraceStart",
+  .function = (ModuleActionFunc)trace_start_action
+};
+
+static void trace_dump_action ( gchar *cmd, gchar *name, void *widget,
+    void *event, window_t *win, guint16 *state )
+{
+  gchar *fname;
+
+  fname = cmd? g_strdup(cmd) :
+    g_build_filename(g_get_user_runtime_dir(), "sfwbar-trace.json", NULL);
+  trace_dump(fname);
+  g_free(fname);
+}
+
+static ModuleActionHandlerV1 trace_dump_handler = {
+  .name = "TraceDump",
+  .function = (ModuleActionFunc)trace_dump_action
+};
+#endif
+
 static void taskbar_item_action ( gchar *cmd, gchar *name, void *widget,
     void *event, window_t *win, void *state )
 {
@@ -598,6 +646,11 @@ static ModuleActionHandlerV1 *action_handlers[] = {
   &eval_handler,
   &switcher_handler,
   &clear_widget_handler,
+#if METRICS
+  &profile_dump_handler,
+  &trace_start_handler,
+  &trace_dump_handler,
+#endif
   &taskbar_item_handler,
   &workspace_activate_handler,
   NULL
@@ -2,10 +2,29 @@
 #include <glib.h>
 #include <gtk/gtk.h>
 #include <gio/gdesktopappinfo.h>
+#include "appinfo.h"
+#include "wintree.h"
+#include "taskbar.h"
+#include "metrics.h"
 
 static GHashTable *app_info_wm_class_map;
+static GHashTable *app_info_icon_cache;
 static GHashTable *icon_map;
 static GtkIconTheme *app_info_theme;
+static guint app_info_serial;
+static gboolean app_info_indexing, app_info_reindex;
+static guint app_info_symbolic_prefs;
+
+static gboolean app_info_prewarm ( gpointer d );
+static gboolean app_info_index_done ( GHashTable *map );
+
+/* results of app_info_icon_lookup, including failed lookups (NULL values)
+ * are memoized until desktop files, icon theme or icon map change */
+static void app_info_icon_cache_flush ( void )
+{
+  if(app_info_icon_cache)
+    g_hash_table_remove_all(app_info_icon_cache);
+}
 
 void app_icon_map_add ( gchar *appid, gchar *icon )
 {
@@ -13,41 +32,122 @@ void app_icon_map_add ( gchar *appid, gchar *icon )
     icon_map = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 
   g_hash_table_insert(icon_map, g_strdup(appid), g_strdup(icon));
+  app_info_icon_cache_flush();
 }
 
-static void app_info_monitor_cb ( GAppInfoMonitor *mon, gpointer d )
+/* the wm class map is built on a worker thread once the bar is up, lookups
+ * issued before the map is ready are resolved without it and are retried
+ * when it arrives (the serial tells images to resolve missing icons again) */
+static gpointer app_info_index_thread ( gpointer d )
 {
-  GDesktopAppInfo *app;
+  GHashTable *map;
   GList *list, *iter;
   const gchar *class, *id;
+  gchar ***search;
+  gint i;
 
+  map = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
   list = g_app_info_get_all();
-  g_hash_table_remove_all(app_info_wm_class_map);
   for(iter=list; iter; iter=g_list_next(iter))
+    if( G_IS_DESKTOP_APP_INFO(iter->data) &&
+        (id = g_app_info_get_id(iter->data)) &&
+        (class = g_desktop_app_info_get_startup_wm_class(iter->data)) )
+      g_hash_table_insert(map, g_strdup(class), g_strdup(id));
+  g_list_free_full(list, g_object_unref);
+
+  /* get gio to build its desktop file search index here as well */
+  search = g_desktop_app_info_search("sfwbar");
+  for(i=0; search[i]; i++)
+    g_strfreev(search[i]);
+  g_free(search);
+
+  g_main_context_invoke(NULL, (GSourceFunc)app_info_index_done, map);
+  return NULL;
+}
+
+static gboolean app_info_index_start ( gpointer d )
+{
+  if(app_info_indexing)
   {
-    if( (id = g_app_info_get_id(iter->data)) &&
-        (app = g_desktop_app_info_new(id)) )
-    {
-      if( (class = g_desktop_app_info_get_startup_wm_class(app)) )
-        g_hash_table_insert(app_info_wm_class_map, g_strdup(class),
-            g_strdup(id));
-      g_object_unref(G_OBJECT(app));
-    }
+    app_info_reindex = TRUE;
+    return FALSE;
   }
-  g_list_free_full(list, g_object_unref);
+  app_info_indexing = TRUE;
+  g_thread_unref(g_thread_new("appinfo", app_info_index_thread, NULL));
+
+  return FALSE;
+}
+
+static gboolean app_info_index_done ( GHashTable *map )
+{
+  if(app_info_wm_class_map)
+    g_hash_table_unref(app_info_wm_class_map);
+  app_info_wm_class_map = map;
+  app_info_indexing = FALSE;
+  app_info_serial++;
+  app_info_icon_cache_flush();
+
+  if(app_info_reindex)
+  {
+    app_info_reindex = FALSE;
+    app_info_index_start(NULL);
+  }
+  else
+  {
+    app_info_prewarm(NULL);
+    taskbar_invalidate_all();
+  }
+
+  return FALSE;
+}
+
+static void app_info_monitor_cb ( GAppInfoMonitor *mon, gpointer d )
+{
+  app_info_index_start(NULL);
+}
+
+guint app_info_get_serial ( void )
+{
+  return app_info_serial;
+}
+
+static gboolean app_info_prewarm ( gpointer d )
+{
+  GList *iter;
+  window_t *win;
+  gchar *appid;
+  gint pref;
+
+  for(iter=wintree_get_list(); iter; iter=g_list_next(iter))
+  {
+    win = iter->data;
+    if(win->appid && *(win->appid))
+      appid = win->appid;
+    else if( !(appid = wintree_appid_map_lookup(win)) )
+      continue;
+    /* warm the symbolic preferences images have asked for so far */
+    for(pref=0; pref<2; pref++)
+      if(app_info_symbolic_prefs & (1<<pref) ||
+          (!pref && !app_info_symbolic_prefs))
+        g_free(app_info_icon_lookup(appid, pref));
+  }
+
+  return FALSE;
 }
 
 void app_info_init ( void )
 {
   GAppInfoMonitor *mon;
 
-  app_info_wm_class_map = g_hash_table_new_full(g_str_hash, g_str_equal,
+  app_info_icon_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
       g_free, g_free);
   app_info_theme = gtk_icon_theme_get_default();
+  g_signal_connect(G_OBJECT(app_info_theme), "changed",
+      (GCallback)app_info_icon_cache_flush, NULL);
   mon = g_app_info_monitor_get();
   g_signal_connect(G_OBJECT(mon), "changed", (GCallback)app_info_monitor_cb,
       NULL);
-  app_info_monitor_cb(mon, NULL);
+  g_idle_add_full(G_PRIORITY_LOW, app_info_index_start, NULL, NULL);
 }
 
 gchar *app_info_icon_test ( const gchar *icon, gboolean symbolic_pref )
@@ -132,13 +232,15 @@ static gchar *app_info_lookup_id ( gchar *app_id, gboolean symbolic_pref )
   }
   g_free(desktop);
 
-  if(!icon && (wmmap = g_hash_table_lookup(app_info_wm_class_map, app_id)) )
+  if(!icon && app_info_wm_class_map &&
+      (wmmap = g_hash_table_lookup(app_info_wm_class_map, app_id)) )
     icon = app_info_icon_get(wmmap, symbolic_pref);
 
   return icon;
 }
 
-gchar *app_info_icon_lookup ( gchar *app_id_in, gboolean symbolic_pref )
+static gchar *app_info_icon_resolve ( gchar *app_id_in,
+    gboolean symbolic_pref )
 {
   gchar *app_id,*clean_app_id, *lower_app_id, *icon;
 
@@ -165,3 +267,30 @@ gchar *app_info_icon_lookup ( gchar *app_id_in, gboolean symbolic_pref )
 
   return icon;
 }
+
+gchar *app_info_icon_lookup ( gchar *app_id, gboolean symbolic_pref )
+{
+  gchar *key, *icon;
+
+  if(!app_id)
+    return NULL;
+
+  app_info_symbolic_prefs |= 1<<(!!symbolic_pref);
+  key = g_strdup_printf("%d:%s", !!symbolic_pref, app_id);
+  if(app_info_icon_cache && g_hash_table_lookup_extended(app_info_icon_cache,
+        key, NULL, (gpointer *)&icon))
+  {
+    METRICS_INC(icon_cache_hits);
+    g_free(key);
+    return g_strdup(icon);
+  }
+
+  METRICS_INC(icon_cache_misses);
+  icon = app_info_icon_resolve(app_id, symbolic_pref);
+  if(app_info_icon_cache)
+    g_hash_table_insert(app_info_icon_cache, key, g_strdup(icon));
+  else
+    g_free(key);
+
+  return icon;
+}
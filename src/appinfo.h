@@ -4,7 +4,8 @@
 
 void app_info_init ( void );
 void app_icon_map_add ( gchar *appid, gchar *icon );
-gchar *app_info_icon_get ( const gchar *app_id, GtkIconTheme *theme );
+gchar *app_info_icon_get ( const gchar *app_id, gboolean symbolic_pref );
 gchar *app_info_icon_lookup ( gchar *app_id, gboolean prefer_symbolic );
+guint app_info_get_serial ( void );
 
 #endif
@@ -21,6 +21,21 @@ static GHashTable *bar_list;
 static GList *mirrors;
 extern GtkApplication *application;
 
+/* settings applied to a bar since its layout was last cleared, settings a
+ * reloaded config doesn't apply again are reset to the bar_new defaults */
+enum {
+  BAR_APPLIED_SIZE = 1<<0,
+  BAR_APPLIED_MARGIN = 1<<1,
+  BAR_APPLIED_LAYER = 1<<2,
+  BAR_APPLIED_EZONE = 1<<3,
+  BAR_APPLIED_ID = 1<<4,
+  BAR_APPLIED_SENSOR = 1<<5,
+  BAR_APPLIED_MIRRORS = 1<<6,
+  BAR_APPLIED_BLOCKS = 1<<7,
+  BAR_APPLIED_MONITOR = 1<<8,
+  BAR_APPLIED_VISIBILITY = 1<<9
+};
+
 static gboolean bar_sensor_unblock_cb ( GtkWidget *self )
 {
   BarPrivate *priv;
@@ -334,24 +349,44 @@ gboolean bar_address_all ( GtkWidget *self, gchar *value,
 void bar_set_mirrors ( GtkWidget *self, gchar *mirror )
 {
   BarPrivate *priv;
+  gchar **targets;
 
   g_return_if_fail(IS_BAR(self));
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_MIRRORS;
 
+  targets = g_strsplit(mirror,";",-1);
+  if(priv->mirror_targets && g_strv_equal(
+        (const gchar * const *)priv->mirror_targets,
+        (const gchar * const *)targets))
+  {
+    g_strfreev(targets);
+    return;
+  }
   g_strfreev(priv->mirror_targets);
-  priv->mirror_targets = g_strsplit(mirror,";",-1);
+  priv->mirror_targets = targets;
   bar_update_monitor(self);
 }
 
 void bar_set_mirror_blocks ( GtkWidget *self, gchar *mirror )
 {
   BarPrivate *priv;
+  gchar **blocks;
 
   g_return_if_fail(IS_BAR(self));
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_BLOCKS;
 
+  blocks = g_strsplit(mirror,";",-1);
+  if(priv->mirror_blocks && g_strv_equal(
+        (const gchar * const *)priv->mirror_blocks,
+        (const gchar * const *)blocks))
+  {
+    g_strfreev(blocks);
+    return;
+  }
   g_strfreev(priv->mirror_blocks);
-  priv->mirror_blocks = g_strsplit(mirror,";",-1);
+  priv->mirror_blocks = blocks;
   bar_update_monitor(self);
 }
 
@@ -361,6 +396,7 @@ void bar_set_id ( GtkWidget *self, gchar *id )
 
   g_return_if_fail(IS_BAR(self));
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_ID;
 
   g_free(priv->bar_id);
   priv->bar_id = g_strdup(id);
@@ -398,6 +434,8 @@ void bar_set_visibility ( GtkWidget *self, const gchar *id, gchar state )
   if(id && priv->bar_id && g_strcmp0(priv->bar_id,id))
     return;
 
+  if(state != 'x' && state != 'v')
+    priv->applied |= BAR_APPLIED_VISIBILITY;
   if(state == 't')
     priv->visible = !priv->visible;
   else if(state == 'h')
@@ -435,6 +473,18 @@ gint bar_get_toplevel_dir ( GtkWidget *widget )
   return toplevel_dir;
 }
 
+static GtkLayerShellLayer bar_layer_parse ( const gchar *layer_str )
+{
+  if(!g_ascii_strcasecmp(layer_str,"background"))
+    return GTK_LAYER_SHELL_LAYER_BACKGROUND;
+  else if(!g_ascii_strcasecmp(layer_str,"bottom"))
+    return GTK_LAYER_SHELL_LAYER_BOTTOM;
+  else if(!g_ascii_strcasecmp(layer_str,"overlay"))
+    return GTK_LAYER_SHELL_LAYER_OVERLAY;
+  else
+    return GTK_LAYER_SHELL_LAYER_TOP;
+}
+
 void bar_set_layer ( GtkWidget *self, gchar *layer_str )
 {
   BarPrivate *priv;
@@ -443,18 +493,11 @@ void bar_set_layer ( GtkWidget *self, gchar *layer_str )
   g_return_if_fail(IS_BAR(self));
   g_return_if_fail(layer_str);
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_LAYER;
 
   g_free(priv->layer);
   priv->layer = g_strdup(layer_str);
-
-  if(!g_ascii_strcasecmp(layer_str,"background"))
-    layer = GTK_LAYER_SHELL_LAYER_BACKGROUND;
-  else if(!g_ascii_strcasecmp(layer_str,"bottom"))
-    layer = GTK_LAYER_SHELL_LAYER_BOTTOM;
-  else if(!g_ascii_strcasecmp(layer_str,"overlay"))
-    layer = GTK_LAYER_SHELL_LAYER_OVERLAY;
-  else
-    layer = GTK_LAYER_SHELL_LAYER_TOP;
+  layer = bar_layer_parse(layer_str);
 
 #if GTK_LAYER_VER_MINOR > 5 || GTK_LAYER_VER_MAJOR > 0
   if(layer == gtk_layer_get_layer(GTK_WINDOW(self)))
@@ -478,6 +521,7 @@ void bar_set_exclusive_zone ( GtkWidget *self, gchar *zone )
   g_return_if_fail(IS_BAR(self));
   g_return_if_fail(zone!=NULL);
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_EZONE;
 
   g_free(priv->ezone);
   priv->ezone = g_strdup(zone);
@@ -516,6 +560,198 @@ gchar *bar_get_output ( GtkWidget *self )
     return g_object_get_data( G_OBJECT(priv->current_monitor), "xdg_name");
 }
 
+/* add mirrors to any outputs where they are missing */
+static void bar_mirrors_add ( GtkWidget *self )
+{
+  BarPrivate *priv;
+  GdkDisplay *gdisp;
+  GdkMonitor *gmon;
+  GList *iter;
+  gint nmon, i;
+  gchar *output;
+  gboolean present;
+
+  priv = bar_get_instance_private(BAR(self));
+  gdisp = gdk_display_get_default();
+  nmon = gdk_display_get_n_monitors(gdisp);
+
+  for(i=0; i<nmon; i++)
+  {
+    gmon = gdk_display_get_monitor(gdisp, i);
+    output = g_object_get_data(G_OBJECT(gmon),"xdg_name");
+    present = FALSE;
+    for(iter=priv->mirror_children; iter; iter=g_list_next(iter))
+      if(bar_get_monitor(iter->data) == gmon)
+        present = TRUE;
+
+    if(!present && gmon != priv->current_monitor &&
+        pattern_match(priv->mirror_targets,output) &&
+        !pattern_match(priv->mirror_blocks,output) )
+      bar_mirror(self, gmon);
+  }
+}
+
+/* drop the layout of all bars ahead of a config reload. Bar windows are
+ * kept so their layer surfaces don't get remapped */
+void bar_layout_clear ( void )
+{
+  BarPrivate *priv;
+  GHashTableIter iter;
+  void *bar;
+
+  if(!bar_list)
+    return;
+
+  g_hash_table_iter_init(&iter,bar_list);
+  while(g_hash_table_iter_next(&iter,NULL,&bar))
+  {
+    priv = bar_get_instance_private(BAR(bar));
+    priv->applied = 0;
+    while(priv->mirror_children)
+      gtk_widget_destroy(priv->mirror_children->data);
+    g_clear_pointer(&priv->start,gtk_widget_destroy);
+    g_clear_pointer(&priv->center,gtk_widget_destroy);
+    g_clear_pointer(&priv->end,gtk_widget_destroy);
+  }
+}
+
+/* remove bars the reloaded config no longer lays out and mirror the rest */
+void bar_layout_finish ( void )
+{
+  BarPrivate *priv;
+  GHashTableIter iter;
+  void *bar;
+
+  if(!bar_list)
+    return;
+
+  g_hash_table_iter_init(&iter,bar_list);
+  while(g_hash_table_iter_next(&iter,NULL,&bar))
+  {
+    priv = bar_get_instance_private(BAR(bar));
+    if(priv->start || priv->center || priv->end)
+      bar_mirrors_add(bar);
+    else
+    {
+      g_hash_table_iter_remove(&iter);
+      gtk_widget_destroy(bar);
+    }
+  }
+}
+
+/* reset settings to the bar_new defaults on a bar and its mirrors */
+static void bar_settings_reset ( GtkWidget *self, guint applied )
+{
+  BarPrivate *priv;
+  GList *iter;
+
+  priv = bar_get_instance_private(BAR(self));
+
+  if(!(applied & BAR_APPLIED_SIZE) && priv->size)
+  {
+    g_clear_pointer(&priv->size, g_free);
+    gtk_widget_set_size_request(self, -1, -1);
+    priv->dir = -1;
+    bar_style_updated(self);
+  }
+  if(!(applied & BAR_APPLIED_MARGIN) && priv->margin)
+  {
+    g_clear_pointer(&priv->margin, g_free);
+#if GTK_LAYER_VER_MINOR > 5 || GTK_LAYER_VER_MAJOR > 0
+    gtk_layer_set_margin(GTK_WINDOW(self), GTK_LAYER_SHELL_EDGE_TOP, 0);
+    gtk_layer_set_margin(GTK_WINDOW(self), GTK_LAYER_SHELL_EDGE_BOTTOM, 0);
+    gtk_layer_set_margin(GTK_WINDOW(self), GTK_LAYER_SHELL_EDGE_LEFT, 0);
+    gtk_layer_set_margin(GTK_WINDOW(self), GTK_LAYER_SHELL_EDGE_RIGHT, 0);
+#endif
+  }
+  if(!(applied & BAR_APPLIED_LAYER) && priv->layer)
+  {
+    if(bar_layer_parse(priv->layer) != GTK_LAYER_SHELL_LAYER_TOP)
+    {
+      gtk_layer_set_layer(GTK_WINDOW(self), GTK_LAYER_SHELL_LAYER_TOP);
+      if(gtk_widget_is_visible(self))
+      {
+        gtk_widget_hide(self);
+        gtk_widget_show_now(self);
+      }
+    }
+    g_clear_pointer(&priv->layer, g_free);
+  }
+  if(!(applied & BAR_APPLIED_EZONE) && priv->ezone)
+  {
+    g_clear_pointer(&priv->ezone, g_free);
+    gtk_layer_auto_exclusive_zone_enable(GTK_WINDOW(self));
+  }
+  if(!(applied & BAR_APPLIED_ID))
+    g_clear_pointer(&priv->bar_id, g_free);
+  if(!(applied & BAR_APPLIED_SENSOR) && priv->sensor_timeout)
+  {
+    priv->sensor_timeout = 0;
+    bar_sensor_show_bar(self);
+  }
+  if(!(applied & BAR_APPLIED_VISIBILITY) && !priv->visible)
+  {
+    priv->visible = TRUE;
+    if(priv->current_monitor && !gtk_widget_is_visible(self))
+      gtk_widget_show_now(self);
+  }
+
+  for(iter=priv->mirror_children; iter; iter=g_list_next(iter))
+    bar_settings_reset(iter->data, applied);
+}
+
+/* called once SfwBarInit of a reloaded config ran, so a reload leaves bars
+ * as a fresh start would */
+void bar_settings_finish ( void )
+{
+  BarPrivate *priv;
+  GHashTableIter iter;
+  GdkMonitor *gmon;
+  gchar *output;
+  void *bar;
+  gboolean update;
+
+  if(!bar_list)
+    return;
+
+  g_hash_table_iter_init(&iter,bar_list);
+  while(g_hash_table_iter_next(&iter,NULL,&bar))
+  {
+    priv = bar_get_instance_private(BAR(bar));
+    bar_settings_reset(bar, priv->applied);
+
+    update = FALSE;
+    if(!(priv->applied & BAR_APPLIED_MIRRORS) && priv->mirror_targets)
+    {
+      g_clear_pointer(&priv->mirror_targets, g_strfreev);
+      update = TRUE;
+    }
+    if(!(priv->applied & BAR_APPLIED_BLOCKS) && priv->mirror_blocks)
+    {
+      g_clear_pointer(&priv->mirror_blocks, g_strfreev);
+      update = TRUE;
+    }
+    gmon = wayland_monitor_get_default();
+    output = gmon? g_object_get_data(G_OBJECT(gmon), "xdg_name") : NULL;
+    if(!(priv->applied & BAR_APPLIED_MONITOR) &&
+        (priv->jump || g_strcmp0(priv->output, output)))
+    {
+      priv->jump = FALSE;
+      g_free(priv->output);
+      priv->output = g_strdup(output);
+      update = TRUE;
+    }
+
+    /* mirrors matching the remaining targets are added back */
+    if(update)
+    {
+      while(priv->mirror_children)
+        gtk_widget_destroy(priv->mirror_children->data);
+      bar_update_monitor(bar);
+    }
+  }
+}
+
 gboolean bar_update_monitor ( GtkWidget *self )
 {
   BarPrivate *priv;
@@ -524,7 +760,6 @@ gboolean bar_update_monitor ( GtkWidget *self )
   GList *iter;
   gint nmon, i;
   gchar *output;
-  gboolean present;
 
   g_return_val_if_fail(IS_BAR(self),FALSE);
   priv = bar_get_instance_private(BAR(self));
@@ -569,21 +804,7 @@ gboolean bar_update_monitor ( GtkWidget *self )
     if(bar_get_monitor(iter->data) == priv->current_monitor)
       bar_destroy(iter->data);
 
-  /* add mirrors to any outputs where they are missing */
-  for(i=0; i<nmon; i++)
-  {
-    gmon = gdk_display_get_monitor(gdisp, i);
-    output = g_object_get_data(G_OBJECT(gmon),"xdg_name");
-    present = FALSE;
-    for(iter=priv->mirror_children; iter; iter=g_list_next(iter))
-      if(bar_get_monitor(iter->data) == gmon)
-        present = TRUE;
-
-    if(!present && gmon != priv->current_monitor &&
-        pattern_match(priv->mirror_targets,output) &&
-        !pattern_match(priv->mirror_blocks,output) )
-      bar_mirror(self, gmon);
-  }
+  bar_mirrors_add(self);
 
   return FALSE;
 }
@@ -596,6 +817,7 @@ void bar_set_monitor ( GtkWidget *self, gchar *monitor )
   g_return_if_fail(IS_BAR(self));
   g_return_if_fail(monitor!=NULL);
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_MONITOR;
 
   if(!g_ascii_strncasecmp(monitor,"static:",7))
   {
@@ -673,6 +895,7 @@ void bar_set_margin ( GtkWidget *self, gchar *margin )
   g_return_if_fail(IS_BAR(self));
   g_return_if_fail(margin != NULL);
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_MARGIN;
   g_free(priv->margin);
   priv->margin = g_strdup(margin);
 #if GTK_LAYER_VER_MINOR > 5 || GTK_LAYER_VER_MAJOR > 0
@@ -696,6 +919,7 @@ void bar_set_size ( GtkWidget *self, gchar *size )
   g_return_if_fail(IS_BAR(self));
   g_return_if_fail(size!=NULL);
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_SIZE;
   g_free(priv->size);
   priv->size = g_strdup(size);
   bar_style_updated(self);
@@ -723,6 +947,7 @@ void bar_set_sensor ( GtkWidget *self, gchar *delay_str )
 
   g_return_if_fail(IS_BAR(self));
   priv = bar_get_instance_private(BAR(self));
+  priv->applied |= BAR_APPLIED_SENSOR;
   priv->sensor_timeout = g_ascii_strtoll(delay_str, NULL, 10);
 
   if(priv->sensor_timeout)
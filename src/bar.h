@@ -51,6 +51,7 @@ struct _BarPrivate {
   gchar **mirror_blocks;
   GList *mirror_children;
   GtkWidget *mirror_parent;
+  guint applied;
 };
 
 GtkWidget *bar_new ( gchar * );
@@ -80,5 +81,8 @@ void bar_set_icon_theme ( gchar *new_theme );
 GtkWidget *bar_mirror ( GtkWidget *, GdkMonitor * );
 void bar_handle_direction ( GtkWidget *self );
 void bar_sensor_cancel_hide ( GtkWidget *self );
+void bar_layout_clear ( void );
+void bar_layout_finish ( void );
+void bar_settings_finish ( void );
 
 #endif
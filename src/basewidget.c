@@ -10,6 +10,8 @@
 #include "action.h"
 #include "module.h"
 #include "meson.h"
+#include "metrics.h"
+#include "trace.h"
 
 G_DEFINE_TYPE_WITH_CODE (BaseWidget, base_widget, GTK_TYPE_EVENT_BOX,
     G_ADD_PRIVATE (BaseWidget))
@@ -38,6 +40,7 @@ static void base_widget_destroy ( GtkWidget *self )
   g_mutex_lock(&widget_mutex);
   widgets_scan = g_list_remove(widgets_scan, self);
   g_mutex_unlock(&widget_mutex);
+  priv->destroyed = TRUE;
 
   if(priv->mirror_parent)
   {
@@ -356,15 +359,20 @@ gboolean base_widget_update_value ( GtkWidget *self )
 {
   BaseWidgetPrivate *priv;
   GList *iter;
+  gint64 trace;
 
   g_return_val_if_fail(IS_BASE_WIDGET(self), FALSE);
   priv = base_widget_get_instance_private(BASE_WIDGET(self));
+  if(priv->destroyed)
+    return FALSE;
 
+  trace = TRACE_BEGIN();
   if(BASE_WIDGET_GET_CLASS(self)->update_value)
     BASE_WIDGET_GET_CLASS(self)->update_value(self);
 
   for(iter=priv->mirror_children; iter; iter=g_list_next(iter))
       BASE_WIDGET_GET_CLASS(self)->update_value(iter->data);
+  TRACE_END(trace, "dispatch", "base_widget_update_value");
 
   return FALSE;
 }
@@ -373,11 +381,15 @@ gboolean base_widget_style ( GtkWidget *self )
 {
   BaseWidgetPrivate *priv;
   GList *iter;
+  gint64 trace;
 
   g_return_val_if_fail(IS_BASE_WIDGET(self), FALSE);
   self = base_widget_get_mirror_parent(self);
   priv = base_widget_get_instance_private(BASE_WIDGET(self));
+  if(priv->destroyed || !priv->style)
+    return FALSE;
 
+  trace = TRACE_BEGIN();
   gtk_widget_set_name(base_widget_get_child(self), priv->style->cache);
   css_widget_cascade(self, NULL);
   for(iter=priv->mirror_children; iter; iter=g_list_next(iter))
@@ -385,6 +397,7 @@ gboolean base_widget_style ( GtkWidget *self )
     gtk_widget_set_name(base_widget_get_child(iter->data), priv->style->cache);
     css_widget_cascade(iter->data, NULL);
   }
+  TRACE_END(trace, "dispatch", "base_widget_style");
 
   return FALSE;
 }
@@ -849,14 +862,21 @@ gpointer base_widget_scanner_thread ( GMainContext *gmc )
 {
   BaseWidgetPrivate *priv;
   GList *iter;
-  gint64 timer, ctime;
+  gint64 timer, ctime, trace;
+  guint evaluated;
+  gboolean invoked;
 
+  trace_thread_name("scanner");
   while ( TRUE )
   {
+    METRICS_INC(scanner_wakeups);
     scanner_invalidate();
     module_invalidate_all();
     timer = G_MAXINT64;
     ctime = g_get_monotonic_time();
+    evaluated = 0;
+    invoked = FALSE;
+    trace = TRACE_BEGIN();
 
     g_mutex_lock(&widget_mutex);
     for(iter=widgets_scan; iter!=NULL; iter=g_list_next(iter))
@@ -864,17 +884,34 @@ gpointer base_widget_scanner_thread ( GMainContext *gmc )
       priv = base_widget_get_instance_private(BASE_WIDGET(iter->data));
       if(base_widget_get_next_poll(iter->data)<=ctime)
       {
+        evaluated++;
+        /* queued updates hold a reference, the widget may be destroyed
+         * (i.e. by a config reload) before they are dispatched */
         if(expr_cache_eval(priv->value) || priv->always_update)
-          g_main_context_invoke(gmc,(GSourceFunc)base_widget_update_value,
-              iter->data);
+        {
+          g_main_context_invoke_full(gmc, G_PRIORITY_DEFAULT,
+              (GSourceFunc)base_widget_update_value,
+              g_object_ref(iter->data), g_object_unref);
+          invoked = TRUE;
+        }
         if(expr_cache_eval(priv->style))
-          g_main_context_invoke(gmc, (GSourceFunc)base_widget_style,
-              iter->data);
+        {
+          g_main_context_invoke_full(gmc, G_PRIORITY_DEFAULT,
+              (GSourceFunc)base_widget_style,
+              g_object_ref(iter->data), g_object_unref);
+          invoked = TRUE;
+        }
         base_widget_set_next_poll(iter->data,ctime);
       }
       timer = MIN(timer, base_widget_get_next_poll(iter->data));
     }
     g_mutex_unlock(&widget_mutex);
+    TRACE_END(trace, "scanner", "scanner_tick");
+
+    METRICS_ADD(widgets_evaluated, evaluated);
+    METRICS_SET(widgets_last_tick, evaluated);
+    if(invoked)
+      metrics_latency_probe(gmc);
 
     timer -= g_get_monotonic_time();
     if(timer>0)
@@ -47,6 +47,7 @@ struct _BaseWidgetPrivate
   gint dir;
   gboolean always_update;
   gboolean is_drag_dest;
+  gboolean destroyed;
   guint16 user_state;
   GdkRectangle rect;
   GList *mirror_children;
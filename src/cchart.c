@@ -12,16 +12,29 @@ G_DEFINE_TYPE_WITH_CODE (CChart, cchart, BASE_WIDGET_TYPE,
 static void cchart_update_value ( GtkWidget *self )
 {
   CChartPrivate *priv;
-  gchar *value;
+  gdouble values[CHART_MAX_SERIES];
+  gchar *value, *ptr, *end;
+  gint n;
 
   g_return_if_fail(IS_CCHART(self));
   priv = cchart_get_instance_private(CCHART(self));
 
   value = base_widget_get_value(self);
 
-  if(!g_strrstr(value,"nan"))
-      chart_update(priv->chart,g_ascii_strtod(value,NULL));
+  if(!value || g_strrstr(value,"nan"))
+    return;
 
+  /* multiple series are separated by spaces, commas or semicolons */
+  for(n=0, ptr=value; n<CHART_MAX_SERIES; n++, ptr=end)
+  {
+    while(*ptr==' ' || *ptr==',' || *ptr==';' || *ptr=='\t')
+      ptr++;
+    values[n] = g_ascii_strtod(ptr, &end);
+    if(end == ptr)
+      break;
+  }
+
+  chart_update(priv->chart, values, MAX(n, 1));
 }
 
 static GtkWidget *cchart_get_child ( GtkWidget *self )
@@ -36,8 +49,14 @@ static GtkWidget *cchart_get_child ( GtkWidget *self )
 
 static GtkWidget *cchart_mirror ( GtkWidget *src )
 {
+  GtkWidget *self;
+
   g_return_val_if_fail(IS_CCHART(src), NULL);
-  return cchart_new();
+
+  self = cchart_new();
+  cchart_set_history(self, chart_get_history(cchart_get_child(src)));
+
+  return self;
 }
 
 static void cchart_class_init ( CChartClass *kclass )
@@ -65,3 +84,13 @@ GtkWidget *cchart_new ( void )
 
   return self;
 }
+
+void cchart_set_history ( GtkWidget *self, gint history )
+{
+  CChartPrivate *priv;
+
+  g_return_if_fail(IS_CCHART(self));
+  priv = cchart_get_instance_private(CCHART(self));
+
+  chart_set_history(priv->chart, history);
+}
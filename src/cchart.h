@@ -32,5 +32,6 @@ struct _CChartPrivate
 GType cchart_get_type ( void );
 
 GtkWidget *cchart_new();
+void cchart_set_history ( GtkWidget *self, gint history );
 
 #endif
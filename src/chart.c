@@ -9,6 +9,11 @@
 
 G_DEFINE_TYPE_WITH_CODE (Chart, chart, GTK_TYPE_BOX, G_ADD_PRIVATE (Chart))
 
+#define CHART_DEFAULT_SIZE 256
+/* longest history accepted from the config, larger values are clamped */
+#define CHART_MAX_HISTORY 4096
+#define CHART_SAMPLE(p,n,s) ((p)->data[((n) % (p)->size) * (p)->nseries + (s)])
+
 static void chart_destroy ( GtkWidget *self )
 {
   ChartPrivate *priv;
@@ -16,10 +21,124 @@ static void chart_destroy ( GtkWidget *self )
   g_return_if_fail(IS_CHART(self));
   priv = chart_get_instance_private(CHART(self));
 
-  g_clear_pointer(&priv->data, g_queue_free);
+  g_clear_pointer(&priv->data, g_free);
+  g_clear_pointer(&priv->cs, cairo_surface_destroy);
   GTK_WIDGET_CLASS(chart_parent_class)->destroy(self);
 }
 
+/* samples are kept in a ring buffer, sample n of series s is stored in
+ * slot n % size, resizing keeps the most recent samples */
+static void chart_resize ( ChartPrivate *priv, gint size, gint nseries )
+{
+  gdouble *data;
+  guint64 n;
+  gint len;
+
+  if(priv->size == size && priv->nseries == nseries)
+    return;
+
+  len = (priv->nseries == nseries)? MIN(priv->len, size) : 0;
+  data = g_malloc0(size * nseries * sizeof(gdouble));
+  for(n=priv->count - len; n<priv->count; n++)
+    memcpy(data + (n % size) * nseries, &CHART_SAMPLE(priv, n, 0),
+        nseries * sizeof(gdouble));
+  g_free(priv->data);
+  priv->data = data;
+  priv->size = size;
+  priv->nseries = nseries;
+  priv->len = len;
+  priv->invalid = TRUE;
+}
+
+/* each pixel column of the offscreen surface shows a bucket of step
+ * samples, bucket b is painted into column b % width. If there are more
+ * samples than columns, each series is drawn as a band from the bucket's
+ * minimum to its maximum */
+static void chart_paint_column ( ChartPrivate *priv, cairo_t *cr, guint64 b )
+{
+  guint64 first, last, oldest, n;
+  gdouble min, max, prev, bottom;
+  GdkRGBA *col;
+  gint c, s;
+
+  oldest = priv->count - priv->len;
+  first = MAX(b * priv->step, oldest);
+  last = MIN((b + 1) * priv->step, priv->count);
+  c = b % priv->width;
+  bottom = priv->height + 0.5;
+
+  cairo_save(cr);
+  cairo_rectangle(cr, c, 0, 1, priv->height + 1);
+  cairo_clip(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+  for(s=0; s<priv->nseries && first<last; s++)
+  {
+    col = &priv->color[s];
+    cairo_set_source_rgba(cr, col->red, col->green, col->blue, col->alpha);
+    if(priv->step == 1)
+    {
+      prev = CHART_SAMPLE(priv, (first > oldest)? first - 1 : first, s);
+      cairo_move_to(cr, c, bottom);
+      cairo_line_to(cr, c, bottom - priv->height * prev);
+      cairo_line_to(cr, c + 1, bottom - priv->height *
+          CHART_SAMPLE(priv, first, s));
+      cairo_line_to(cr, c + 1, bottom);
+      cairo_close_path(cr);
+      cairo_stroke_preserve(cr);
+      cairo_fill(cr);
+    }
+    else
+    {
+      min = max = CHART_SAMPLE(priv, first, s);
+      for(n=first+1; n<last; n++)
+      {
+        min = MIN(min, CHART_SAMPLE(priv, n, s));
+        max = MAX(max, CHART_SAMPLE(priv, n, s));
+      }
+      cairo_rectangle(cr, c, bottom - priv->height * min, 1,
+          priv->height * min);
+      cairo_fill(cr);
+      cairo_set_source_rgba(cr, col->red, col->green, col->blue,
+          col->alpha / 2);
+      cairo_rectangle(cr, c, bottom - priv->height * max, 1,
+          priv->height * (max - min));
+      cairo_fill(cr);
+    }
+  }
+  cairo_restore(cr);
+}
+
+static void chart_get_colors ( GtkWidget *self, GdkRGBA *colors )
+{
+  GtkStyleContext *context;
+  GdkRGBA *color;
+  gchar name[8];
+  gint i;
+
+  context = gtk_widget_get_style_context(self);
+  gtk_style_context_get_color(context, gtk_style_context_get_state(context),
+      &colors[0]);
+
+  for(i=1; i<CHART_MAX_SERIES; i++)
+  {
+    g_snprintf(name, sizeof(name), "color%d", i);
+    gtk_widget_style_get(self, name, &color, NULL);
+    if(color)
+    {
+      colors[i] = *color;
+      gdk_rgba_free(color);
+    }
+    else
+    {
+      colors[i] = colors[0];
+      colors[i].alpha *= 1.0 - 0.25 * i;
+    }
+  }
+}
+
 static gboolean chart_draw ( GtkWidget *self, cairo_t *cr )
 {
   ChartPrivate *priv;
@@ -27,9 +146,10 @@ static gboolean chart_draw ( GtkWidget *self, cairo_t *cr )
   gint width,height;
   GtkBorder border,margin,padding,extents;
   GtkStateFlags flags;
-  GdkRGBA fg;
-  gdouble x_offset, y_offset;
-  gint i, len;
+  GdkRGBA colors[CHART_MAX_SERIES];
+  cairo_t *ccr;
+  guint64 last;
+  gint i, scale, step, visible, head;
 
   g_return_val_if_fail(IS_CHART(self),FALSE);
   priv = chart_get_instance_private(CHART(self));
@@ -57,25 +177,68 @@ static gboolean chart_draw ( GtkWidget *self, cairo_t *cr )
   if( width<1 || height<1 )
     return FALSE;
 
-  while(g_queue_get_length(priv->data)>width)
-    g_free(g_queue_pop_head(priv->data));
+  /* without explicit history, keep one sample per pixel column */
+  chart_resize(priv, priv->history? priv->history : width, priv->nseries);
+  step = MAX(1, (priv->size + width - 1) / width);
+  scale = gtk_widget_get_scale_factor(self);
+  chart_get_colors(self, colors);
+
+  /* repaint everything on resize or style change */
+  if(!priv->cs || priv->invalid || priv->dirty >= width ||
+      priv->width != width || priv->height != height ||
+      priv->step != step || priv->scale != scale ||
+      memcmp(colors, priv->color, sizeof(colors)))
+  {
+    g_clear_pointer(&priv->cs, cairo_surface_destroy);
+    priv->cs = cairo_surface_create_similar(cairo_get_target(cr),
+        CAIRO_CONTENT_COLOR_ALPHA, width, height + 1);
+    priv->width = width;
+    priv->height = height;
+    priv->step = step;
+    priv->scale = scale;
+    memcpy(priv->color, colors, sizeof(colors));
+    priv->invalid = FALSE;
+    priv->dirty = width;
+  }
+
+  if(!priv->count || !priv->len)
+    return TRUE;
 
-  len = g_queue_get_length(priv->data);
+  last = (priv->count - 1) / step;
+  visible = MIN(last - (priv->count - priv->len) / step + 1, width);
 
-  x_offset = width + extents.left - len + 0.5;
-  y_offset = height + extents.top + 0.5;
+  if(priv->dirty)
+  {
+    ccr = cairo_create(priv->cs);
+    cairo_set_line_width(ccr,1);
+    for(i=MIN(priv->dirty, visible)-1; i>=0; i--)
+      chart_paint_column(priv, ccr, last - i);
+    cairo_destroy(ccr);
+    priv->dirty = 0;
+  }
 
-  gtk_style_context_get_color (context,flags, &fg);
-  cairo_set_source_rgba(cr,fg.red,fg.green,fg.blue,fg.alpha);
-  cairo_set_line_width(cr,1);
-  cairo_move_to(cr,x_offset,y_offset);
-  for(i=0;i<len;i++)
-    cairo_line_to(cr, x_offset + i, y_offset -
-        height * *(gdouble *)g_queue_peek_nth(priv->data,i));
-  cairo_line_to(cr,x_offset + len - 1, y_offset);
-  cairo_close_path(cr);
-  cairo_stroke_preserve(cr);
-  cairo_fill(cr);
+  /* the oldest column follows the newest one, paint the surface in two
+   * pieces to put the newest bucket at the right edge */
+  head = (last + 1) % width;
+  cairo_save(cr);
+  cairo_rectangle(cr, extents.left + width - visible, extents.top, visible,
+      height + 1);
+  cairo_clip(cr);
+
+  cairo_save(cr);
+  cairo_rectangle(cr, extents.left, extents.top, width - head, height + 1);
+  cairo_clip(cr);
+  cairo_set_source_surface(cr, priv->cs, extents.left - head, extents.top);
+  cairo_paint(cr);
+  cairo_restore(cr);
+
+  cairo_rectangle(cr, extents.left + width - head, extents.top, head,
+      height + 1);
+  cairo_clip(cr);
+  cairo_set_source_surface(cr, priv->cs, extents.left + width - head,
+      extents.top);
+  cairo_paint(cr);
+  cairo_restore(cr);
 
   return TRUE;
 }
@@ -86,6 +249,19 @@ static void chart_class_init ( ChartClass *kclass )
   gtk_widget_class_set_css_name(GTK_WIDGET_CLASS(kclass),"chart");
   widget_class->destroy = chart_destroy;
   widget_class->draw = chart_draw;
+
+  gtk_widget_class_install_style_property( widget_class,
+      g_param_spec_boxed("color1","second series color",
+        "color to draw the second data series with",
+        GDK_TYPE_RGBA,G_PARAM_READABLE));
+  gtk_widget_class_install_style_property( widget_class,
+      g_param_spec_boxed("color2","third series color",
+        "color to draw the third data series with",
+        GDK_TYPE_RGBA,G_PARAM_READABLE));
+  gtk_widget_class_install_style_property( widget_class,
+      g_param_spec_boxed("color3","fourth series color",
+        "color to draw the fourth data series with",
+        GDK_TYPE_RGBA,G_PARAM_READABLE));
 }
 
 static void chart_init ( Chart *self )
@@ -95,7 +271,10 @@ static void chart_init ( Chart *self )
   g_return_if_fail(IS_CHART(self));
   priv = chart_get_instance_private(CHART(self));
 
-  priv->data = g_queue_new();
+  priv->size = CHART_DEFAULT_SIZE;
+  priv->nseries = 1;
+  priv->step = 1;
+  priv->data = g_malloc0(priv->size * sizeof(gdouble));
 }
 
 GtkWidget *chart_new( void )
@@ -103,14 +282,50 @@ GtkWidget *chart_new( void )
   return GTK_WIDGET(g_object_new(chart_get_type(), NULL));
 }
 
-int chart_update ( GtkWidget *self, gdouble n )
+void chart_set_history ( GtkWidget *self, gint history )
 {
   ChartPrivate *priv;
 
+  g_return_if_fail(IS_CHART(self));
+  priv = chart_get_instance_private(CHART(self));
+
+  priv->history = CLAMP(history, 0, CHART_MAX_HISTORY);
+  if(priv->history)
+    chart_resize(priv, priv->history, priv->nseries);
+  gtk_widget_queue_draw(self);
+}
+
+gint chart_get_history ( GtkWidget *self )
+{
+  ChartPrivate *priv;
+
+  g_return_val_if_fail(IS_CHART(self), 0);
+  priv = chart_get_instance_private(CHART(self));
+
+  return priv->history;
+}
+
+int chart_update ( GtkWidget *self, gdouble *values, gint nseries )
+{
+  ChartPrivate *priv;
+  gint s;
+
   g_return_val_if_fail(IS_CHART(self),0);
   priv = chart_get_instance_private(CHART(self));
 
-  g_queue_push_tail(priv->data,g_memdup(&n,sizeof(double)));
+  if(!priv->data || nseries < 1)
+    return 0;
+
+  chart_resize(priv, priv->size, MIN(nseries, CHART_MAX_SERIES));
+  for(s=0; s<priv->nseries; s++)
+    CHART_SAMPLE(priv, priv->count, s) = values[s];
+
+  if(!(priv->count % priv->step))
+    priv->dirty++;
+  else
+    priv->dirty = MAX(priv->dirty, 1);
+  priv->count++;
+  priv->len = MIN(priv->len + 1, priv->size);
   gtk_widget_queue_draw(self);
 
   return 0;
@@ -9,6 +9,8 @@
 #define IS_CHART(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj), CHART_TYPE))
 #define IS_CHART_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), CHART_TYPE))
 
+#define CHART_MAX_SERIES 4
+
 typedef struct _Chart Chart;
 typedef struct _ChartClass ChartClass;
 
@@ -26,13 +28,25 @@ typedef struct _ChartPrivate ChartPrivate;
 
 struct _ChartPrivate
 {
-  GQueue *data;
+  gdouble *data;
+  gint nseries;
+  gint history;
+  gint size, len;
+  guint64 count;
+  gint step;
+  gint dirty;
+  gboolean invalid;
+  cairo_surface_t *cs;
+  gint width, height, scale;
+  GdkRGBA color[CHART_MAX_SERIES];
   GtkWidget *chart;
 };
 
 GType chart_get_type ( void );
 
 GtkWidget *chart_new( void );
-int chart_update ( GtkWidget *widget, gdouble n );
+int chart_update ( GtkWidget *widget, gdouble *values, gint nseries );
+void chart_set_history ( GtkWidget *widget, gint history );
+gint chart_get_history ( GtkWidget *widget );
 
 #endif
@@ -151,7 +151,7 @@ void client_socket ( ScanFile *file )
 {
   Client *client;
 
-  if( !file || !file->fname )
+  if( !file || !file->fname || file->client )
     return;
 
   client = g_malloc0(sizeof(Client));
@@ -178,6 +178,7 @@ gboolean client_exec_connect ( Client *client )
     return FALSE;
   }
   g_strfreev(argv);
+  scanner_file_spawned(client->file);
 
   client->in = g_io_channel_unix_new(out);
   client->out = g_io_channel_unix_new(in);
@@ -190,7 +191,7 @@ void client_exec ( ScanFile *file )
 {
   Client *client;
 
-  if( !file || !file->fname )
+  if( !file || !file->fname || file->client )
     return;
 
   client = g_malloc0(sizeof(Client));
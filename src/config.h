@@ -26,6 +26,7 @@ gint config_lookup_key ( GScanner *scanner, GHashTable *table );
 gint config_lookup_next_key ( GScanner *scanner, GHashTable *table );
 gchar *config_value_string ( gchar *dest, gchar *string );
 GtkWidget *config_parse ( gchar *, gboolean );
+gboolean config_files_changed ( void );
 void config_pipe_read ( gchar *command );
 void config_string ( gchar *string );
 gboolean config_expect_token ( GScanner *scan, gint token, gchar *fmt, ...);
@@ -131,6 +132,7 @@ enum {
   G_TOKEN_WORKSPACE,
   G_TOKEN_OUTPUT,
   G_TOKEN_FLOATING,
+  G_TOKEN_HISTORY,
 };
 
 #endif
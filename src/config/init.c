@@ -6,6 +6,7 @@
 #include "../config.h"
 #include "../sfwbar.h"
 #include "../taskbar.h"
+#include "../trace.h"
 
 GHashTable *config_mods, *config_events, *config_var_types, *config_act_cond;
 GHashTable *config_toplevel_keys, *config_menu_keys, *config_scanner_keys;
@@ -16,6 +17,11 @@ GHashTable *config_prop_keys, *config_placer_keys, *config_flowgrid_props;
 #define config_add_key(table, str, key) \
   g_hash_table_insert(table, str, GINT_TO_POINTER(key))
 
+/* digests of the config files read, used to detect changed files on
+ * reload. Checking contents rather than mtime catches edits made within
+ * the same second */
+static GHashTable *config_files;
+
 void config_init ( void )
 {
   config_mods = g_hash_table_new((GHashFunc)str_nhash, (GEqualFunc)str_nequal);
@@ -165,6 +171,7 @@ void config_init ( void )
   config_add_key(config_prop_keys, "Tooltip", G_TOKEN_TOOLTIP);
   config_add_key(config_prop_keys, "Group", G_TOKEN_GROUP);
   config_add_key(config_prop_keys, "Filter", G_TOKEN_FILTER);
+  config_add_key(config_prop_keys, "History", G_TOKEN_HISTORY);
 
 config_flowgrid_props = g_hash_table_new((GHashFunc)str_nhash,
       (GEqualFunc)str_nequal);
@@ -219,7 +226,6 @@ GtkWidget *config_parse_data ( gchar *fname, gchar *data, gboolean toplevel )
 {
   GScanner *scanner;
   GtkWidget *w;
-  GtkCssProvider *css;
   gchar *tmp;
 
   if(!data)
@@ -245,11 +251,8 @@ GtkWidget *config_parse_data ( gchar *fname, gchar *data, gboolean toplevel )
   if(tmp)
   {
     *tmp=0;
-    css = gtk_css_provider_new();
-    gtk_css_provider_load_from_data(css,tmp+5,strlen(tmp+5),NULL);
-    gtk_style_context_add_provider_for_screen(gdk_screen_get_default(),
-      GTK_STYLE_PROVIDER(css),GTK_STYLE_PROVIDER_PRIORITY_USER);
-    g_object_unref(css);
+    css_data_load(config_files && g_hash_table_contains(config_files, fname)?
+        fname : NULL, tmp+5);
   }
 
   scanner->input_name = fname;
@@ -301,19 +304,61 @@ void config_pipe_read ( gchar *command )
   pclose(fp);
 }
 
+static gchar *config_file_read ( gchar *fname )
+{
+  gchar *conf;
+  gsize size;
+
+  if(!fname || !g_file_get_contents(fname, &conf, &size, NULL))
+    return NULL;
+
+  if(!config_files)
+    config_files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        g_free);
+  g_hash_table_replace(config_files, g_strdup(fname),
+      g_compute_checksum_for_data(G_CHECKSUM_SHA1, (guchar *)conf, size));
+
+  return conf;
+}
+
+/* check if any config file read so far was modified since */
+gboolean config_files_changed ( void )
+{
+  GHashTableIter iter;
+  gchar *fname, *digest, *conf, *new;
+  gsize size;
+  gboolean changed = FALSE;
+
+  if(!config_files)
+    return FALSE;
+
+  g_hash_table_iter_init(&iter, config_files);
+  while(!changed &&
+      g_hash_table_iter_next(&iter, (gpointer *)&fname, (gpointer *)&digest))
+  {
+    if(!g_file_get_contents(fname, &conf, &size, NULL))
+      return TRUE;
+    new = g_compute_checksum_for_data(G_CHECKSUM_SHA1, (guchar *)conf, size);
+    changed = g_strcmp0(new, digest);
+    g_free(new);
+    g_free(conf);
+  }
+
+  return changed;
+}
+
 GtkWidget *config_parse ( gchar *file, gboolean toplevel )
 {
   gchar *fname, *dir, *base ,*cssfile, *csspath, *tmp;
-  gchar *conf=NULL;
-  gsize size;
+  gchar *conf;
   GtkWidget *w=NULL;
+  gint64 start;
 
+  start = trace_startup_begin();
   fname = get_xdg_config_file(file,NULL);
   g_debug("include: %s -> %s",file,fname);
 
-  if(fname)
-    if(!g_file_get_contents(fname,&conf,&size,NULL))
-      conf=NULL;
+  conf = config_file_read(fname);
 
   if(!conf)
   {
@@ -335,6 +380,7 @@ GtkWidget *config_parse ( gchar *file, gboolean toplevel )
   csspath = g_build_filename(dir,cssfile,NULL);
 
   css_file_load (csspath);
+  trace_startup_end(start, "config", fname);
 
   g_free(csspath);
   g_free(cssfile);
@@ -310,6 +310,14 @@ gboolean config_widget_property ( GScanner *scanner, GtkWidget *widget )
         }
     }
 
+  if(IS_CCHART(widget))
+    switch(key)
+    {
+      case G_TOKEN_HISTORY:
+        cchart_set_history(widget, config_assign_number(scanner, "history"));
+        return TRUE;
+    }
+
   win = GTK_WINDOW(gtk_widget_get_ancestor(widget,GTK_TYPE_WINDOW));
   if(win && gtk_bin_get_child(GTK_BIN(win)) == widget &&
       gtk_window_get_window_type(win) == GTK_WINDOW_POPUP)
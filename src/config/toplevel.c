@@ -8,6 +8,7 @@
 #include "../sfwbar.h"
 #include "../module.h"
 #include "../bar.h"
+#include "../trace.h"
 
 gboolean config_action_conditions ( GScanner *scanner, action_t *action )
 {
@@ -297,6 +298,7 @@ if(!scanner->max_parse_errors)
 void config_module ( GScanner *scanner )
 {
   gchar *name;
+  gint64 start;
 
   config_parse_sequence(scanner,
       SEQ_REQ, '(', NULL, NULL, "missing '(' after 'module'",
@@ -306,7 +308,11 @@ void config_module ( GScanner *scanner )
       SEQ_END);
 
   if(!scanner->max_parse_errors && name)
+  {
+    start = trace_startup_begin();
     module_load ( name );
+    trace_startup_end(start, "module", name);
+  }
 
   g_free(name);
 }
@@ -7,35 +7,177 @@
 #include "basewidget.h"
 #include "bar.h"
 #include "window.h"
+#include "trace.h"
 
 static void (*css_style_updated_original)(GtkWidget *);
 
-void css_file_load ( gchar *name )
+/* css sources are loaded once, so config files included several times
+ * don't add duplicate providers. A source that changed replaces the provider
+ * loaded from it earlier */
+typedef struct css_source {
+  gchar *digest;
+  gchar *data;
+  GtkCssProvider *provider;
+} css_source_t;
+
+static GHashTable *css_files, *css_data;
+/* identical per widget css snippets share one parsed provider */
+static GHashTable *css_providers;
+
+static void css_source_free ( css_source_t *source )
 {
+  if(source->provider)
+    gtk_style_context_remove_provider_for_screen(gdk_screen_get_default(),
+        GTK_STYLE_PROVIDER(source->provider));
+  g_clear_object(&source->provider);
+  g_free(source->digest);
+  g_free(source->data);
+  g_free(source);
+}
+
+static css_source_t *css_source_get ( GHashTable **table, const gchar *name )
+{
+  css_source_t *source;
+
+  if(!*table)
+    *table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify)css_source_free);
+
+  if( !(source = g_hash_table_lookup(*table, name)) )
+  {
+    source = g_malloc0(sizeof(css_source_t));
+    g_hash_table_insert(*table, g_strdup(name), source);
+  }
+
+  return source;
+}
+
+static void css_source_set ( css_source_t *source, GtkCssProvider *css )
+{
+  if(source->provider)
+    gtk_style_context_remove_provider_for_screen(gdk_screen_get_default(),
+        GTK_STYLE_PROVIDER(source->provider));
+  g_clear_object(&source->provider);
+  source->provider = css;
+  gtk_style_context_add_provider_for_screen(gdk_screen_get_default(),
+    GTK_STYLE_PROVIDER(css),GTK_STYLE_PROVIDER_PRIORITY_USER);
+}
+
+static gboolean css_file_update ( const gchar *fname )
+{
+  css_source_t *source;
   GtkCssProvider *css;
+  gchar *data, *digest;
+  gsize size;
+
+  /* compare contents, mtime misses edits made within the same second */
+  if(!g_file_get_contents(fname, &data, &size, NULL))
+    return FALSE;
+  digest = g_compute_checksum_for_data(G_CHECKSUM_SHA1, (guchar *)data, size);
+  g_free(data);
+
+  source = css_source_get(&css_files, fname);
+  if(source->provider && !g_strcmp0(source->digest, digest))
+  {
+    g_free(digest);
+    return FALSE;
+  }
+  g_free(source->digest);
+  source->digest = digest;
+
+  /* load from path, so relative urls resolve against the file */
+  css = gtk_css_provider_new();
+  gtk_css_provider_load_from_path(css,fname,NULL);
+  css_source_set(source, css);
+
+  return TRUE;
+}
+
+void css_file_load ( gchar *name )
+{
   gchar *fname;
 
   if(!name)
     return;
 
   fname = get_xdg_config_file(name,NULL);
-  if(!fname)
+  if(fname)
+    css_file_update(fname);
+  g_free(fname);
+}
+
+/* css embedded in a named source replaces the css it embedded before,
+ * anonymous sources just add theirs */
+void css_data_load ( const gchar *name, gchar *data )
+{
+  css_source_t *source;
+  GtkCssProvider *css;
+
+  if(!data)
     return;
 
+  if(name)
+  {
+    source = css_source_get(&css_data, name);
+    if(source->provider && !g_strcmp0(source->data, data))
+      return;
+    g_free(source->data);
+    source->data = g_strdup(data);
+  }
+  else
+    source = NULL;
+
   css = gtk_css_provider_new();
-  gtk_css_provider_load_from_path(css,fname,NULL);
-  gtk_style_context_add_provider_for_screen(gdk_screen_get_default(),
-    GTK_STYLE_PROVIDER(css),GTK_STYLE_PROVIDER_PRIORITY_USER);
-  g_object_unref(css);
-  g_free(fname);
+  gtk_css_provider_load_from_data(css,data,strlen(data),NULL);
+  if(source)
+    css_source_set(source, css);
+  else
+  {
+    gtk_style_context_add_provider_for_screen(gdk_screen_get_default(),
+      GTK_STYLE_PROVIDER(css),GTK_STYLE_PROVIDER_PRIORITY_USER);
+    g_object_unref(css);
+  }
 }
 
+/* reload css files whose contents changed since they were loaded */
+gboolean css_reload ( void )
+{
+  GHashTableIter iter;
+  gchar *fname;
+  gboolean changed = FALSE;
+
+  /* widgets hold their own references to the providers they use */
+  if(css_providers)
+    g_hash_table_remove_all(css_providers);
+
+  if(!css_files)
+    return FALSE;
+
+  g_hash_table_iter_init(&iter, css_files);
+  while(g_hash_table_iter_next(&iter, (gpointer *)&fname, NULL))
+    changed |= css_file_update(fname);
+
+  return changed;
+}
+
+/* resolved custom properties are cached per widget and only the changed
+ * ones are applied. Visible widgets get a style-updated whenever their
+ * style changes, so cascades only resolve widgets that are hidden or were
+ * never resolved */
+typedef struct css_custom {
+  gboolean hexpand, vexpand;
+  GtkAlign halign, valign;
+  guint max_width, max_height;
+  gdouble xalign;
+  gboolean ellipsize;
+} css_custom_t;
+
+static GQuark css_custom_quark;
+
 static void css_custom_handle ( GtkWidget *widget )
 {
+  css_custom_t *old, new;
   gboolean state;
-  gdouble xalign;
-  GtkAlign align;
-  guint x;
 
   gtk_widget_style_get(widget, "visible", &state, NULL);
   if(state)
@@ -46,39 +188,65 @@ static void css_custom_handle ( GtkWidget *widget )
       window_collapse_popups(widget);
     gtk_widget_hide(widget);
   }
+
+  old = g_object_get_qdata(G_OBJECT(widget), css_custom_quark);
+  memset(&new, 0, sizeof(new));
+
   if(!GTK_IS_EVENT_BOX(widget))
   {
-    gtk_widget_style_get(widget, "hexpand", &state, NULL);
-    gtk_widget_set_hexpand(widget, state);
-    gtk_widget_style_get(widget, "vexpand", &state, NULL);
-    gtk_widget_set_vexpand(widget, state);
-    gtk_widget_style_get(widget, "halign", &align, NULL);
-    gtk_widget_set_halign(widget, align);
-    gtk_widget_style_get(widget, "valign", &align, NULL);
-    gtk_widget_set_valign(widget, align);
+    gtk_widget_style_get(widget, "hexpand", &new.hexpand,
+        "vexpand", &new.vexpand, "halign", &new.halign,
+        "valign", &new.valign, NULL);
+    if(!old || old->hexpand != new.hexpand)
+      gtk_widget_set_hexpand(widget, new.hexpand);
+    if(!old || old->vexpand != new.vexpand)
+      gtk_widget_set_vexpand(widget, new.vexpand);
+    if(!old || old->halign != new.halign)
+      gtk_widget_set_halign(widget, new.halign);
+    if(!old || old->valign != new.valign)
+      gtk_widget_set_valign(widget, new.valign);
   }
   if(IS_BASE_WIDGET(widget))
   {
-    gtk_widget_style_get(base_widget_get_child(widget), "max-width", &x,NULL);
-    base_widget_set_max_width(widget, x);
-    gtk_widget_style_get(base_widget_get_child(widget), "max-height", &x,NULL);
-    base_widget_set_max_height(widget, x);
+    gtk_widget_style_get(base_widget_get_child(widget),
+        "max-width", &new.max_width, "max-height", &new.max_height, NULL);
+    if(!old || old->max_width != new.max_width)
+      base_widget_set_max_width(widget, new.max_width);
+    if(!old || old->max_height != new.max_height)
+      base_widget_set_max_height(widget, new.max_height);
   }
 
   if(GTK_IS_LABEL(widget))
   {
-    gtk_widget_style_get(widget, "align", &xalign, NULL);
-    gtk_label_set_xalign(GTK_LABEL(widget), xalign);
-    gtk_widget_style_get(widget, "ellipsize", &state, NULL);
-    gtk_label_set_ellipsize(GTK_LABEL(widget),
-        state?PANGO_ELLIPSIZE_END:PANGO_ELLIPSIZE_NONE);
+    gtk_widget_style_get(widget, "align", &new.xalign,
+        "ellipsize", &new.ellipsize, NULL);
+    if(!old || old->xalign != new.xalign)
+      gtk_label_set_xalign(GTK_LABEL(widget), new.xalign);
+    if(!old || old->ellipsize != new.ellipsize)
+      gtk_label_set_ellipsize(GTK_LABEL(widget),
+          new.ellipsize?PANGO_ELLIPSIZE_END:PANGO_ELLIPSIZE_NONE);
   }
+
+  if(!old)
+  {
+    old = g_malloc(sizeof(css_custom_t));
+    g_object_set_qdata_full(G_OBJECT(widget), css_custom_quark, old, g_free);
+  }
+  *old = new;
 }
 
 static void css_style_updated ( GtkWidget *widget )
 {
+  GtkWidget *parent;
+
   css_style_updated_original(widget);
   css_custom_handle(widget);
+
+  /* max-width/height of a base widget are set on its child */
+  parent = gtk_widget_get_parent(widget);
+  if(parent && IS_BASE_WIDGET(parent) &&
+      base_widget_get_child(parent) == widget)
+    css_custom_handle(parent);
 }
 
 void css_init ( gchar *cssname )
@@ -87,12 +255,18 @@ void css_init ( gchar *cssname )
   GtkCssProvider *css;
   GtkWidgetClass *widget_class = g_type_class_ref(GTK_TYPE_WIDGET);
 
+  css_custom_quark = g_quark_from_static_string("sfwbar-css-custom");
+
   gtk_widget_class_install_style_property(widget_class,
     g_param_spec_double("align","text alignment","text alignment",
       0.0,1.0,0.5, G_PARAM_READABLE));
   gtk_widget_class_install_style_property(widget_class,
     g_param_spec_boolean("ellipsize","ellipsize text","ellipsize text",
       TRUE, G_PARAM_READABLE));
+  gtk_widget_class_install_style_property(widget_class,
+    g_param_spec_boolean("keep-width","keep width",
+      "keep label width at the widest text displayed", FALSE,
+      G_PARAM_READABLE));
 
   gtk_widget_class_install_style_property(widget_class,
     g_param_spec_boolean("hexpand","horizonal expansion","horizontal expansion",
@@ -172,21 +346,41 @@ void css_widget_apply ( GtkWidget *widget, gchar *css )
   if(!css)
     return;
 
+  if(!css_providers)
+    css_providers = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        g_object_unref);
+
+  if( (provider = g_hash_table_lookup(css_providers, css)) )
+    g_free(css);
+  else
+  {
+    provider = gtk_css_provider_new();
+    gtk_css_provider_load_from_data(provider,css,strlen(css),NULL);
+    g_hash_table_insert(css_providers, css, provider);
+  }
+
   cont = gtk_widget_get_style_context (widget);
-  provider = gtk_css_provider_new();
-  gtk_css_provider_load_from_data(provider,css,strlen(css),NULL);
   gtk_style_context_add_provider (cont,
     GTK_STYLE_PROVIDER(provider), GTK_STYLE_PROVIDER_PRIORITY_USER);
-  g_object_unref(provider);
-  g_free(css);
 }
 
-void css_widget_cascade ( GtkWidget *widget, gpointer data )
+static void css_widget_cascade_tree ( GtkWidget *widget, gpointer data )
 {
-  css_custom_handle(widget);
+  if(!gtk_widget_get_visible(widget) ||
+      !g_object_get_qdata(G_OBJECT(widget), css_custom_quark))
+    css_custom_handle(widget);
 
   if(GTK_IS_CONTAINER(widget))
-    gtk_container_forall(GTK_CONTAINER(widget),css_widget_cascade,NULL);
+    gtk_container_forall(GTK_CONTAINER(widget),css_widget_cascade_tree,NULL);
+}
+
+void css_widget_cascade ( GtkWidget *widget, gpointer data )
+{
+  gint64 trace;
+
+  trace = TRACE_BEGIN();
+  css_widget_cascade_tree(widget, data);
+  TRACE_END(trace, "css", "css_widget_cascade");
 }
 
 void css_add_class ( GtkWidget *widget, gchar *css_class )
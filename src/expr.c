@@ -12,8 +12,14 @@
 #include "sfwbar.h"
 #include "wintree.h"
 #include "module.h"
+#include "trace.h"
+#include "metrics.h"
 
 static GHashTable *expr_deps;
+#if METRICS
+static GHashTable *expr_list;
+static GMutex expr_list_mutex;
+#endif
 
 static gdouble expr_parse_num ( GScanner *scanner, gdouble * );
 static gchar *expr_parse_str ( GScanner *scanner, gchar * );
@@ -792,38 +798,66 @@ gchar *expr_parse( ExprCache *expr )
 gboolean expr_cache_eval ( ExprCache *expr )
 {
   gchar *eval;
+  gint64 start, end;
+  gboolean changed;
 
   if(!expr || !expr->definition || !expr->eval)
     return FALSE;
 
+  start = METRICS_NOW();
   expr->vstate = FALSE;
   eval = expr_parse(expr);
+  end = METRICS_NOW();
+  TRACE_SPAN(start, end, "expr", "expr_cache_eval");
 
   if(!expr->vstate)
     expr->eval = FALSE;
 
-  if(g_strcmp0(eval,expr->cache))
+  if( (changed = g_strcmp0(eval,expr->cache)) )
   {
     g_free(expr->cache);
     expr->cache = eval;
-    return TRUE;
   }
   else
-  {
     g_free(eval);
-    return FALSE;
-  }
+
+#if METRICS
+  /* an expression is only evaluated by the thread owning its widget, the
+   * dump accepts racy reads of the counters */
+  expr->evals++;
+  expr->unchanged += !changed;
+  expr->eval_time += end - start;
+  expr->eval_max = MAX(expr->eval_max, end - start);
+#endif
+
+  return changed;
 }
 
 ExprCache *expr_cache_new ( void )
 {
-  return g_malloc0(sizeof(ExprCache));
+  ExprCache *expr;
+
+  expr = g_malloc0(sizeof(ExprCache));
+#if METRICS
+  g_mutex_lock(&expr_list_mutex);
+  if(!expr_list)
+    expr_list = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_hash_table_add(expr_list, expr);
+  g_mutex_unlock(&expr_list_mutex);
+#endif
+
+  return expr;
 }
 
 void expr_cache_free ( ExprCache *expr )
 {
   if(!expr)
     return;
+#if METRICS
+  g_mutex_lock(&expr_list_mutex);
+  g_hash_table_remove(expr_list, expr);
+  g_mutex_unlock(&expr_list_mutex);
+#endif
   expr_dep_remove(expr);
   g_free(expr->definition);
   g_free(expr->cache);
@@ -886,3 +920,54 @@ void expr_dep_dump ( void )
 {
   g_hash_table_foreach(expr_deps,expr_dep_dump_each,NULL);
 }
+
+#if METRICS
+guint expr_cache_count ( void )
+{
+  guint count;
+
+  g_mutex_lock(&expr_list_mutex);
+  count = expr_list? g_hash_table_size(expr_list) : 0;
+  g_mutex_unlock(&expr_list_mutex);
+
+  return count;
+}
+
+static gint expr_profile_comp ( ExprCache **e1, ExprCache **e2 )
+{
+  return (*e1)->eval_time < (*e2)->eval_time? 1 :
+    ((*e1)->eval_time > (*e2)->eval_time? -1 : 0);
+}
+
+/* print expressions with the highest cumulative evaluation time */
+void expr_profile_dump ( gint count )
+{
+  GPtrArray *list;
+  GHashTableIter iter;
+  ExprCache *expr;
+  gint i;
+
+  list = g_ptr_array_new();
+  g_mutex_lock(&expr_list_mutex);
+  if(expr_list)
+  {
+    g_hash_table_iter_init(&iter, expr_list);
+    while(g_hash_table_iter_next(&iter, (gpointer *)&expr, NULL))
+      if(expr->evals)
+        g_ptr_array_add(list, expr);
+  }
+  g_ptr_array_sort(list, (GCompareFunc)expr_profile_comp);
+
+  g_message("profile: %8s %9s %10s %8s  expression", "evals", "unchanged",
+      "total ms", "max ms");
+  for(i=0; i<(gint)list->len && i<count; i++)
+  {
+    expr = g_ptr_array_index(list, i);
+    g_message("profile: %8u %9u %10.1f %8.2f  %.60s", expr->evals,
+        expr->unchanged, expr->eval_time/1000.0, expr->eval_max/1000.0,
+        expr->definition);
+  }
+  g_mutex_unlock(&expr_list_mutex);
+  g_ptr_array_free(list, TRUE);
+}
+#endif
@@ -2,6 +2,7 @@
 #define __EXPR_H__
 
 #include <gtk/gtk.h>
+#include "meson.h"
 
 enum {
   G_TOKEN_IF      = G_TOKEN_LAST + 1,
@@ -26,6 +27,10 @@ typedef struct expr_cache {
   gboolean eval;
   guint vstate;
   struct expr_cache *parent;
+#if METRICS
+  guint evals, unchanged;
+  gint64 eval_time, eval_max;
+#endif
 } ExprCache;
 
 typedef struct expr_state {
@@ -47,5 +52,9 @@ void expr_dep_add ( gchar *ident, ExprCache *expr );
 void expr_dep_remove ( ExprCache *expr );
 void expr_dep_trigger ( gchar *ident );
 void expr_dep_dump ( void );
+#if METRICS
+guint expr_cache_count ( void );
+void expr_profile_dump ( gint count );
+#endif
 
 #endif
@@ -10,10 +10,14 @@
 #include "config.h"
 #include "window.h"
 #include "bar.h"
+#include "trace.h"
 
 G_DEFINE_TYPE_WITH_CODE (FlowGrid, flow_grid, BASE_WIDGET_TYPE,
     G_ADD_PRIVATE(FlowGrid))
 
+static GList *flow_grid_pending;
+static guint flow_grid_dispatch_id;
+
 static GtkWidget *flow_grid_get_child ( GtkWidget *self )
 {
   FlowGridPrivate *priv;
@@ -62,6 +66,9 @@ static void flow_grid_destroy( GtkWidget *self )
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
   g_clear_pointer(&priv->dnd_target, gtk_target_entry_free);
+  g_clear_pointer(&priv->index, g_hash_table_destroy);
+  g_clear_pointer(&priv->fillers, g_list_free);
+  priv->queued = FALSE;
   g_list_free_full(g_steal_pointer(&priv->children),
       (GDestroyNotify)gtk_widget_destroy);
   GTK_WIDGET_CLASS(flow_grid_parent_class)->destroy(self);
@@ -230,31 +237,86 @@ void flow_grid_set_sort ( GtkWidget *self, gboolean sort )
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
   priv->sort = sort;
+  priv->sorted = FALSE;
   flow_grid_invalidate(self);
 }
 
-void flow_grid_remove_widget ( GtkWidget *widget, GtkWidget *self )
+/* invalidated grids are updated from a single idle callback, scheduled
+ * ahead of gtk relayout and redraw. Nothing runs while nothing changes */
+static gboolean flow_grid_dispatch ( gpointer data )
+{
+  FlowGridPrivate *priv;
+  GList *list, *iter;
+
+  flow_grid_dispatch_id = 0;
+  list = g_list_reverse(g_steal_pointer(&flow_grid_pending));
+
+  for(iter=list; iter; iter=g_list_next(iter))
+  {
+    priv = flow_grid_get_instance_private(FLOW_GRID(iter->data));
+    if(priv->queued)
+    {
+      priv->queued = FALSE;
+      flow_grid_update(iter->data);
+    }
+  }
+  g_list_free_full(list, g_object_unref);
+
+  return FALSE;
+}
+
+static void flow_grid_queue ( GtkWidget *self )
 {
   FlowGridPrivate *priv;
 
-  g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  gtk_container_remove (GTK_CONTAINER(priv->grid), widget);
+  priv->invalid = TRUE;
+  if(!priv->queued && !gtk_widget_in_destruction(self))
+  {
+    priv->queued = TRUE;
+    flow_grid_pending = g_list_prepend(flow_grid_pending, g_object_ref(self));
+  }
+  if(!flow_grid_dispatch_id)
+    flow_grid_dispatch_id = g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+        flow_grid_dispatch, NULL, NULL);
 }
 
 void flow_grid_invalidate ( GtkWidget *self )
 {
-  FlowGridPrivate *priv;
   GList *iter;
 
   g_return_if_fail(IS_FLOW_GRID(self));
-  priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
   for(iter=base_widget_get_mirror_children(self); iter; iter=g_list_next(iter))
     flow_grid_invalidate(iter->data);
 
-  priv->invalid = TRUE;
+  flow_grid_queue(self);
+}
+
+/* children are indexed by their source, the hash and equality functions
+ * are provided by the flow item class and default to comparing pointers */
+static void flow_grid_index_add ( GtkWidget *self, GtkWidget *child )
+{
+  FlowGridPrivate *priv;
+  FlowItemClass *kclass;
+  gpointer source;
+
+  priv = flow_grid_get_instance_private(FLOW_GRID(self));
+
+  if(!(source = flow_item_get_source(child)))
+    return;
+
+  if(!priv->index)
+  {
+    kclass = FLOW_ITEM_GET_CLASS(child);
+    priv->index = g_hash_table_new(
+        kclass->hash_source?kclass->hash_source:g_direct_hash,
+        kclass->equal_source?kclass->equal_source:g_direct_equal);
+  }
+
+  if(!g_hash_table_contains(priv->index, source))
+    g_hash_table_insert(priv->index, source, child);
 }
 
 void flow_grid_add_child ( GtkWidget *self, GtkWidget *child )
@@ -268,36 +330,88 @@ void flow_grid_add_child ( GtkWidget *self, GtkWidget *child )
   for(i=0; i<=BASE_WIDGET_MAX_ACTION; i++)
     base_widget_action_configure(child, i);
   priv->children = g_list_append(priv->children, child);
+  flow_grid_index_add(self, child);
   flow_item_set_parent(child, self);
-  priv->invalid = TRUE;
+  flow_grid_queue(self);
 }
 
 void flow_grid_delete_child ( GtkWidget *self, void *source )
 {
   FlowGridPrivate *priv;
-  GList *iter;
+  GtkWidget *child;
 
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  if(!priv->children || !priv->children->data)
+  if( !(child = flow_grid_find_child(self, source)) )
     return;
 
-  for(iter=priv->children; iter; iter=g_list_next(iter))
-    if(!flow_item_check_source(iter->data, source))
-    {
-      g_object_unref(iter->data);
-      priv->children = g_list_delete_link(priv->children, iter);
-      break;
-    }
-  priv->invalid = TRUE;
+  g_hash_table_remove(priv->index, source);
+  priv->children = g_list_remove(priv->children, child);
+  if(gtk_widget_get_parent(child) == GTK_WIDGET(priv->grid))
+    gtk_container_remove(GTK_CONTAINER(priv->grid), child);
+  g_object_unref(child);
+  flow_grid_queue(self);
+}
+
+/* place a widget at a grid position, only touching the GtkGrid if the
+ * widget isn't already attached at this position. Returns TRUE if the
+ * widget got newly attached */
+static gboolean flow_grid_place ( GtkWidget *self, GtkWidget *widget,
+    gint x, gint y )
+{
+  FlowGridPrivate *priv;
+  gint ox, oy;
+
+  priv = flow_grid_get_instance_private(FLOW_GRID(self));
+
+  if(gtk_widget_get_parent(widget) != GTK_WIDGET(priv->grid))
+  {
+    gtk_grid_attach(priv->grid, widget, x, y, 1, 1);
+    return TRUE;
+  }
+
+  gtk_container_child_get(GTK_CONTAINER(priv->grid), widget,
+      "left-attach", &ox, "top-attach", &oy, NULL);
+  if(ox!=x || oy!=y)
+    gtk_container_child_set(GTK_CONTAINER(priv->grid), widget,
+        "left-attach", x, "top-attach", y, NULL);
+
+  return FALSE;
+}
+
+/* keep the children list sorted. Invalidated children are taken out and
+ * inserted back into their sorted position, unless there are enough of
+ * them to make sorting the whole list cheaper */
+static void flow_grid_sort ( GtkWidget *self, GList *dirty, guint ndirty )
+{
+  FlowGridPrivate *priv;
+  GList *iter;
+
+  priv = flow_grid_get_instance_private(FLOW_GRID(self));
+
+  if(!priv->sorted || ndirty*4 > g_list_length(priv->children))
+  {
+    priv->children = g_list_sort_with_data(priv->children,
+        (GCompareDataFunc)flow_item_compare, self);
+    priv->sorted = TRUE;
+    return;
+  }
+
+  for(iter=dirty; iter; iter=g_list_next(iter))
+    priv->children = g_list_remove(priv->children, iter->data);
+  for(iter=dirty; iter; iter=g_list_next(iter))
+    priv->children = g_list_insert_sorted_with_data(priv->children,
+        iter->data, (GCompareDataFunc)flow_item_compare, self);
 }
 
 void flow_grid_update ( GtkWidget *self )
 {
   FlowGridPrivate *priv, *ppriv;
-  GList *iter;
-  gint count, i, cols, rows;
+  GList *iter, *link, *dirty = NULL, *changed = NULL;
+  gint count, i, cols, rows, nfill;
+  guint ndirty = 0;
+  gint64 trace;
 
   g_return_if_fail(IS_FLOW_GRID(self));
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
@@ -307,6 +421,7 @@ void flow_grid_update ( GtkWidget *self )
   if(!priv->invalid)
     return;
   priv->invalid = FALSE;
+  trace = TRACE_BEGIN();
 
   if(!ppriv->primary_axis)
   {
@@ -316,21 +431,22 @@ void flow_grid_update ( GtkWidget *self )
       ppriv->primary_axis = G_TOKEN_ROWS;
   }
 
-  gtk_container_foreach(GTK_CONTAINER(priv->grid),
-      (GtkCallback)flow_grid_remove_widget, self);
-
-  if(ppriv->sort)
-    priv->children = g_list_sort_with_data(priv->children,
-        (GCompareDataFunc)flow_item_compare, self);
-
   count = 0;
   for(iter=priv->children; iter; iter=g_list_next(iter))
   {
-    flow_item_update(iter->data);
+    if(flow_item_get_invalid(iter->data))
+    {
+      flow_item_update(iter->data);
+      dirty = g_list_prepend(dirty, iter->data);
+      ndirty++;
+    }
     if(flow_item_get_active(iter->data))
       count++;
   }
 
+  if(ppriv->sort)
+    flow_grid_sort(self, dirty, ndirty);
+
   rows = 0;
   cols = 0;
   if(ppriv->rows>0)
@@ -350,21 +466,48 @@ void flow_grid_update ( GtkWidget *self )
 
   i = 0;
   for(iter=priv->children; iter; iter=g_list_next(iter))
-    if(flow_item_get_active(iter->data))
+    if(flow_item_get_active(iter->data) && (rows>0 || cols>0))
     {
-      if(rows>0)
-        gtk_grid_attach(priv->grid, iter->data, i/rows, i%rows, 1, 1);
-      else if(cols>0)
-        gtk_grid_attach(priv->grid, iter->data, i%cols, i/cols, 1, 1);
+      if( (rows>0 && flow_grid_place(self, iter->data, i/rows, i%rows)) ||
+          (rows<=0 && flow_grid_place(self, iter->data, i%cols, i/cols)) )
+        changed = g_list_prepend(changed, iter->data);
       i++;
     }
-  if(rows>0)
-    for(;i<rows; i++)
-      gtk_grid_attach(priv->grid, gtk_label_new(""), 0, i, 1, 1);
+    else if(gtk_widget_get_parent(iter->data) == GTK_WIDGET(priv->grid))
+      gtk_container_remove(GTK_CONTAINER(priv->grid), iter->data);
+
+  /* pad the grid with filler labels, reusing the ones we already have */
+  nfill = MAX(0, (rows>0?rows:cols) - i);
+  while((gint)g_list_length(priv->fillers) > nfill)
+  {
+    link = g_list_last(priv->fillers);
+    gtk_widget_destroy(link->data);
+    priv->fillers = g_list_delete_link(priv->fillers, link);
+  }
+  while((gint)g_list_length(priv->fillers) < nfill)
+    priv->fillers = g_list_append(priv->fillers, gtk_label_new(""));
+
+  for(iter=priv->fillers; iter; iter=g_list_next(iter), i++)
+    if( (rows>0 && flow_grid_place(self, iter->data, 0, i)) ||
+        (rows<=0 && flow_grid_place(self, iter->data, i, 0)) )
+      changed = g_list_prepend(changed, iter->data);
+
+  if(!priv->cascaded)
+  {
+    css_widget_cascade(self, NULL);
+    priv->cascaded = TRUE;
+  }
   else
-    for(;i<cols;i++)
-      gtk_grid_attach(priv->grid, gtk_label_new(""), i, 0, 1, 1);
-  css_widget_cascade(self, NULL);
+  {
+    for(iter=dirty; iter; iter=g_list_next(iter))
+      if(!g_list_find(changed, iter->data))
+        css_widget_cascade(iter->data, NULL);
+    g_list_foreach(changed, (GFunc)css_widget_cascade, NULL);
+  }
+
+  g_list_free(dirty);
+  g_list_free(changed);
+  TRACE_END(trace, "widget", "flow_grid_update");
 }
 
 guint flow_grid_n_children ( GtkWidget *self )
@@ -386,19 +529,14 @@ guint flow_grid_n_children ( GtkWidget *self )
 gpointer flow_grid_find_child ( GtkWidget *self, gconstpointer source )
 {
   FlowGridPrivate *priv;
-  GList *iter;
 
   g_return_val_if_fail(IS_FLOW_GRID(self), NULL);
   priv = flow_grid_get_instance_private(FLOW_GRID(self));
 
-  if(!priv->children || !priv->children->data)
+  if(!priv->index || !source)
     return NULL;
 
-  for(iter=priv->children; iter; iter=g_list_next(iter))
-    if(!flow_item_check_source(iter->data, source))
-      return iter->data;
-
-  return NULL;
+  return g_hash_table_lookup(priv->index, source);
 }
 
 void flow_grid_children_order ( GtkWidget *self, GtkWidget *ref,
@@ -38,7 +38,12 @@ struct _FlowGridPrivate
   gboolean limit;
   gboolean invalid;
   gboolean sort;
+  gboolean sorted;
+  gboolean cascaded;
+  gboolean queued;
   GList *children;
+  GList *fillers;
+  GHashTable *index;
   gint (*comp)( GtkWidget *, GtkWidget *, GtkWidget * );
   GtkTargetEntry *dnd_target;
   GtkWidget *parent;
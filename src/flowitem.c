@@ -92,26 +92,48 @@ gboolean flow_item_get_active ( GtkWidget *self )
   return priv->active;
 }
 
+gboolean flow_item_get_invalid ( GtkWidget *self )
+{
+  FlowItemPrivate *priv;
+
+  g_return_val_if_fail(IS_FLOW_ITEM(self),FALSE);
+
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
+  return priv->invalid;
+}
+
 static void flow_item_init ( FlowItem *self )
 {
+  FlowItemPrivate *priv;
+
+  priv = flow_item_get_instance_private(self);
+  priv->invalid = TRUE;
   flow_item_set_active(GTK_WIDGET(self),TRUE);
 }
 
 void flow_item_update ( GtkWidget *self )
 {
+  FlowItemPrivate *priv;
+
   g_return_if_fail(IS_FLOW_ITEM(self));
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
 
   if(FLOW_ITEM_GET_CLASS(self)->update)
     FLOW_ITEM_GET_CLASS(self)->update(self);
+  priv->invalid = FALSE;
 }
 
 void flow_item_invalidate ( GtkWidget *self )
 {
+  FlowItemPrivate *priv;
+
   if(!self)
     return;
 
   g_return_if_fail(IS_FLOW_ITEM(self));
+  priv = flow_item_get_instance_private(FLOW_ITEM(self));
 
+  priv->invalid = TRUE;
   if(FLOW_ITEM_GET_CLASS(self)->invalidate)
     FLOW_ITEM_GET_CLASS(self)->invalidate(self);
 }
@@ -29,6 +29,8 @@ struct _FlowItemClass
   gint (*compare) (GtkWidget *, GtkWidget *, GtkWidget *);
   void (*dnd_dest) ( GtkWidget *self, GtkWidget *src, gint x, gint y );
   GCompareFunc comp_source;
+  GHashFunc hash_source;
+  GEqualFunc equal_source;
 };
 
 typedef struct _FlowItemPrivate FlowItemPrivate;
@@ -36,6 +38,7 @@ typedef struct _FlowItemPrivate FlowItemPrivate;
 struct _FlowItemPrivate
 {
   gboolean active;
+  gboolean invalid;
   GtkWidget *parent;
 };
 
@@ -47,6 +50,7 @@ void *flow_item_get_source ( GtkWidget *self );
 void flow_item_set_parent ( GtkWidget *self, GtkWidget *parent );
 void flow_item_set_active ( GtkWidget *self, gboolean );
 gboolean flow_item_get_active ( GtkWidget *self );
+gboolean flow_item_get_invalid ( GtkWidget *self );
 gint flow_item_compare ( GtkWidget *p1, GtkWidget *p2, GtkWidget *parent );
 void flow_item_dnd_dest ( GtkWidget *self, GtkWidget *src, gint x, gint y );
 gint flow_item_check_source ( GtkWidget *self, gconstpointer source );
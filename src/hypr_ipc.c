@@ -6,6 +6,8 @@
 #include "sfwbar.h"
 #include "wintree.h"
 #include "pager.h"
+#include "metrics.h"
+#include "trace.h"
 #include <sys/socket.h>
 
 #define hypr_ipc_parse_id(x) GSIZE_TO_POINTER(g_ascii_strtoull(x,NULL,16))
@@ -51,10 +53,13 @@ static gboolean hypr_ipc_window_geom ( json_object *json, GdkRectangle *res )
 static gboolean hypr_ipc_request ( gchar *addr, gchar *command, json_object **json )
 {
   gint sock;
+  gint64 start, trace;
 
   if(!command)
     return FALSE;
 
+  start = METRICS_NOW();
+  trace = TRACE_BEGIN();
   sock = socket_connect(addr,1000);
   if(sock==-1)
   {
@@ -73,6 +78,9 @@ static gboolean hypr_ipc_request ( gchar *addr, gchar *command, json_object **js
     *json = recv_json(sock,-1);
 
   close(sock);
+  METRICS_INC(ipc_requests);
+  METRICS_TIME(ipc_request_time, ipc_request_max, start);
+  TRACE_END(trace, "ipc", "hypr_ipc_request");
   return TRUE;
 }
 
@@ -529,12 +537,15 @@ static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
     gpointer data)
 {
   gchar *event,*ptr;
+  gint64 trace;
 
   (void)g_io_channel_read_line(chan,&event,NULL,NULL,NULL);
   while(event)
   {
     if((ptr=strchr(event,'\n')))
       *ptr=0;
+    METRICS_INC(ipc_events);
+    trace = TRACE_BEGIN();
     g_debug("hypr event: %s",event);
     if(!strncmp(event,"activewindow>>",14))
       hypr_ipc_track_focus();
@@ -559,6 +570,7 @@ static gboolean hypr_ipc_event ( GIOChannel *chan, GIOCondition cond,
       hypr_ipc_floating_set(event+20);
     else if(!strncmp(event,"destroyworkspace>>",18))
       workspace_unref(workspace_id_from_name(event+18));
+    TRACE_END(trace, "ipc", "hypr_ipc_event");
     g_free(event);
     (void)g_io_channel_read_line(chan,&event,NULL,NULL,NULL);
   }
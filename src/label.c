@@ -12,16 +12,36 @@ G_DEFINE_TYPE_WITH_CODE (Label, label, BASE_WIDGET_TYPE, G_ADD_PRIVATE (Label))
 static void label_update_value ( GtkWidget *self )
 {
   LabelPrivate *priv;
-  gchar *value;
+  gboolean reserve;
+  gchar *value, *text = NULL;
+  gint len;
 
   g_return_if_fail(IS_LABEL(self));
   priv = label_get_instance_private(LABEL(self));
 
   value = base_widget_get_value(self);
-  if(value && pango_parse_markup(value, -1, 0, NULL, NULL, NULL, NULL))
+  if(priv->last && !g_strcmp0(value, priv->last))
+    return;
+  g_free(priv->last);
+  priv->last = g_strdup(value);
+
+  gtk_widget_style_get(priv->label, "keep-width", &reserve, NULL);
+
+  /* text without tags or entities reads the same as markup or plain text */
+  if(value && (strchr(value, '<') || strchr(value, '&')) &&
+      pango_parse_markup(value, -1, 0, NULL, reserve?&text:NULL, NULL, NULL))
     gtk_label_set_markup(GTK_LABEL(priv->label), value);
   else
     gtk_label_set_text(GTK_LABEL(priv->label), value);
+
+  /* grow the label to the widest text seen, so it doesn't resize back */
+  if(reserve)
+  {
+    len = g_utf8_strlen(text?text:(value?value:""), -1);
+    if(len > gtk_label_get_width_chars(GTK_LABEL(priv->label)))
+      gtk_label_set_width_chars(GTK_LABEL(priv->label), len);
+  }
+  g_free(text);
 }
 
 static GtkWidget *label_get_child ( GtkWidget *self )
@@ -34,6 +54,17 @@ static GtkWidget *label_get_child ( GtkWidget *self )
   return priv->label;
 }
 
+static void label_destroy ( GtkWidget *self )
+{
+  LabelPrivate *priv;
+
+  g_return_if_fail(IS_LABEL(self));
+  priv = label_get_instance_private(LABEL(self));
+
+  g_clear_pointer(&priv->last, g_free);
+  GTK_WIDGET_CLASS(label_parent_class)->destroy(self);
+}
+
 static GtkWidget *label_mirror ( GtkWidget *src )
 {
   g_return_val_if_fail(IS_LABEL(src), NULL);
@@ -45,6 +76,7 @@ static void label_class_init ( LabelClass *kclass )
   BASE_WIDGET_CLASS(kclass)->update_value = label_update_value;
   BASE_WIDGET_CLASS(kclass)->get_child = label_get_child;
   BASE_WIDGET_CLASS(kclass)->mirror = label_mirror;
+  GTK_WIDGET_CLASS(kclass)->destroy = label_destroy;
 }
 
 static void label_init ( Label *self )
@@ -27,6 +27,7 @@ typedef struct _LabelPrivate LabelPrivate;
 struct _LabelPrivate
 {
   GtkWidget *label;
+  gchar *last;
 };
 
 GType label_get_type ( void );
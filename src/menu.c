@@ -39,6 +39,25 @@ void menu_remove ( gchar *name )
   g_hash_table_remove(menus, name);
 }
 
+/* remove all named menus ahead of a config reload */
+void menu_remove_all ( void )
+{
+  GList *names, *iter;
+
+  if(menu_items)
+    g_hash_table_remove_all(menu_items);
+
+  if(!menus)
+    return;
+
+  names = g_hash_table_get_keys(menus);
+  for(iter=names; iter; iter=g_list_next(iter))
+    iter->data = g_strdup(iter->data);
+  for(iter=names; iter; iter=g_list_next(iter))
+    menu_remove(iter->data);
+  g_list_free_full(names, g_free);
+}
+
 void menu_item_remove ( gchar *id )
 {
   GtkWidget *item;
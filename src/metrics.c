@@ -0,0 +1,185 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2024- sfwbar maintainers
+ */
+
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "expr.h"
+#include "scanner.h"
+#include "wintree.h"
+#include "metrics.h"
+
+#if METRICS
+
+metrics_t metrics;
+
+static gint64 metrics_start;
+static gint64 metrics_last_time;
+static guint metrics_last_wakeups;
+
+static gboolean metrics_latency_cb ( gint64 *queued )
+{
+  gint64 latency;
+
+  latency = g_get_monotonic_time() - *queued;
+  metrics.update_probes++;
+  metrics.update_latency = latency;
+  metrics.update_latency_sum += latency;
+  metrics.update_latency_max = MAX(metrics.update_latency_max, latency);
+
+  return FALSE;
+}
+
+/* measure how long updates queued by the scanner thread wait for the main
+ * loop. The probe is queued after the updates of a tick */
+void metrics_latency_probe ( GMainContext *gmc )
+{
+  gint64 *queued;
+
+  queued = g_malloc(sizeof(gint64));
+  *queued = g_get_monotonic_time();
+  g_main_context_invoke_full(gmc, G_PRIORITY_DEFAULT,
+      (GSourceFunc)metrics_latency_cb, queued, g_free);
+}
+
+static glong metrics_rss ( void )
+{
+  gchar *statm;
+  glong rss = 0;
+
+  if(g_file_get_contents("/proc/self/statm", &statm, NULL, NULL))
+  {
+    if(sscanf(statm, "%*d %ld", &rss) != 1)
+      rss = 0;
+    g_free(statm);
+  }
+
+  return rss * sysconf(_SC_PAGESIZE);
+}
+
+static void metrics_print ( GString *str, const gchar *name,
+    const gchar *fmt, ... )
+{
+  va_list args;
+
+  g_string_append_printf(str, "sfwbar_%s ", name);
+  va_start(args, fmt);
+  g_string_append_vprintf(str, fmt, args);
+  va_end(args);
+  g_string_append_c(str, '\n');
+}
+
+static gchar *metrics_format ( void )
+{
+  GString *str;
+  gint64 now;
+  guint wakeups;
+  gdouble rate;
+
+  now = g_get_monotonic_time();
+  wakeups = METRICS_GET(scanner_wakeups);
+  rate = (guint)(wakeups - metrics_last_wakeups) * 1e6 /
+    MAX(now - metrics_last_time, 1);
+  metrics_last_wakeups = wakeups;
+  metrics_last_time = now;
+
+  str = g_string_new(NULL);
+  metrics_print(str, "uptime_seconds", "%.3f", (now - metrics_start)/1e6);
+  metrics_print(str, "scanner_wakeups_total", "%u", wakeups);
+  metrics_print(str, "scanner_wakeups_per_second", "%.3f", rate);
+  metrics_print(str, "widgets_evaluated_total", "%u",
+      METRICS_GET(widgets_evaluated));
+  metrics_print(str, "widgets_evaluated_last_tick", "%u",
+      METRICS_GET(widgets_last_tick));
+  metrics_print(str, "update_latency_seconds", "%.6f",
+      metrics.update_latency/1e6);
+  metrics_print(str, "update_latency_seconds_max", "%.6f",
+      metrics.update_latency_max/1e6);
+  metrics_print(str, "update_latency_seconds_avg", "%.6f",
+      metrics.update_latency_sum/1e6/MAX(metrics.update_probes, 1));
+  metrics_print(str, "ipc_events_total", "%u", METRICS_GET(ipc_events));
+  metrics_print(str, "ipc_requests_total", "%u", METRICS_GET(ipc_requests));
+  metrics_print(str, "ipc_request_seconds_avg", "%.6f",
+      metrics.ipc_request_time/1e6/MAX(METRICS_GET(ipc_requests), 1));
+  metrics_print(str, "ipc_request_seconds_max", "%.6f",
+      metrics.ipc_request_max/1e6);
+  metrics_print(str, "icon_cache_hits_total{cache=\"surface\"}", "%u",
+      METRICS_GET(surface_cache_hits));
+  metrics_print(str, "icon_cache_misses_total{cache=\"surface\"}", "%u",
+      METRICS_GET(surface_cache_misses));
+  metrics_print(str, "icon_cache_hits_total{cache=\"appinfo\"}", "%u",
+      METRICS_GET(icon_cache_hits));
+  metrics_print(str, "icon_cache_misses_total{cache=\"appinfo\"}", "%u",
+      METRICS_GET(icon_cache_misses));
+  metrics_print(str, "expr_caches", "%u", expr_cache_count());
+  metrics_print(str, "scan_vars", "%u", scanner_var_count());
+  metrics_print(str, "windows", "%u", g_list_length(wintree_get_list()));
+  metrics_print(str, "rss_bytes", "%ld", metrics_rss());
+
+  return g_string_free(str, FALSE);
+}
+
+static gboolean metrics_incoming ( GSocketService *service,
+    GSocketConnection *conn, GObject *source, gpointer d )
+{
+  GOutputStream *out;
+  gchar *text;
+
+  text = metrics_format();
+  out = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+  (void)g_output_stream_write_all(out, text, strlen(text), NULL, NULL, NULL);
+  (void)g_io_stream_close(G_IO_STREAM(conn), NULL, NULL);
+  g_free(text);
+
+  return TRUE;
+}
+
+/* serve the counters as "name value" lines to each connection */
+void metrics_init ( gchar *path )
+{
+  GSocketService *service;
+  GSocketAddress *addr;
+  GError *error = NULL;
+
+  metrics_start = g_get_monotonic_time();
+  metrics_last_time = metrics_start;
+
+  if(!path)
+    return;
+
+  (void)g_unlink(path);
+  service = g_socket_service_new();
+  addr = g_unix_socket_address_new(path);
+  if(!g_socket_listener_add_address(G_SOCKET_LISTENER(service), addr,
+      G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, &error))
+  {
+    g_message("metrics: unable to listen on %s: %s", path, error->message);
+    g_error_free(error);
+    g_object_unref(addr);
+    g_object_unref(service);
+    return;
+  }
+  g_object_unref(addr);
+  /* the umask is process wide and other threads are already running, so
+   * restrict the socket after binding instead */
+  if(g_chmod(path, 0600))
+    g_message("metrics: unable to set permissions on %s", path);
+
+  g_signal_connect(service, "incoming", G_CALLBACK(metrics_incoming), NULL);
+  g_socket_service_start(service);
+}
+
+#else
+
+void metrics_init ( gchar *path )
+{
+  if(path)
+    g_message("metrics: sfwbar was built without metrics support");
+}
+
+#endif
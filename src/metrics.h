@@ -0,0 +1,50 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <glib.h>
+#include "meson.h"
+
+/* counters are updated from the scanner thread as well as the main thread,
+ * so they are only accessed via g_atomic. Timings are main thread only */
+typedef struct metrics {
+  guint scanner_wakeups;
+  guint widgets_evaluated;
+  guint widgets_last_tick;
+  guint ipc_events;
+  guint ipc_requests;
+  guint surface_cache_hits, surface_cache_misses;
+  guint icon_cache_hits, icon_cache_misses;
+  guint64 update_probes;
+  gint64 update_latency, update_latency_max, update_latency_sum;
+  gint64 ipc_request_time, ipc_request_max;
+} metrics_t;
+
+/* instrumentation compiles out when built with -Dmetrics=disabled */
+#if METRICS
+extern metrics_t metrics;
+
+#define METRICS_INC(counter) g_atomic_int_inc(&metrics.counter)
+#define METRICS_ADD(counter, value) \
+  (void)g_atomic_int_add(&metrics.counter, (value))
+#define METRICS_SET(counter, value) g_atomic_int_set(&metrics.counter, (value))
+#define METRICS_GET(counter) ((guint)g_atomic_int_get(&metrics.counter))
+#define METRICS_NOW() g_get_monotonic_time()
+#define METRICS_TIME(total, max, start) G_STMT_START { \
+  gint64 metrics_elapsed = g_get_monotonic_time() - (start); \
+  metrics.total += metrics_elapsed; \
+  metrics.max = MAX(metrics.max, metrics_elapsed); \
+  } G_STMT_END
+
+void metrics_latency_probe ( GMainContext *gmc );
+#else
+#define METRICS_INC(counter) ((void)0)
+#define METRICS_ADD(counter, value) ((void)(value))
+#define METRICS_SET(counter, value) ((void)(value))
+#define METRICS_NOW() 0
+#define METRICS_TIME(total, max, start) ((void)(start))
+#define metrics_latency_probe(gmc) ((void)(gmc))
+#endif
+
+void metrics_init ( gchar *path );
+
+#endif
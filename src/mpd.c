@@ -83,6 +83,13 @@ void client_mpd ( ScanFile *file )
   if( !file || !file->fname )
     return;
 
+  if(file->client)
+  {
+    file->trigger = g_intern_static_string("mpd");
+    scanner_file_attach(file->trigger, file);
+    return;
+  }
+
   client = g_malloc0(sizeof(Client));
   client->file = file;
   client->data = g_malloc0(sizeof(MpdState));
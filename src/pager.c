@@ -121,8 +121,3 @@ void pager_item_add ( workspace_t *ws )
 {
   g_list_foreach(pagers, (GFunc)pager_item_new, ws);
 }
-
-void pager_update_all ( void )
-{
-  g_list_foreach(pagers, (GFunc)flow_grid_update, NULL);
-}
@@ -40,6 +40,5 @@ void pager_add_pin ( GtkWidget *pager, gchar *pin );
 gboolean pager_check_pins ( GtkWidget *self, gchar *pin );
 void pager_item_add ( workspace_t *ws );
 void pager_item_delete ( workspace_t *ws );
-void pager_update_all ( void );
 
 #endif
@@ -258,3 +258,21 @@ GtkWidget *popup_from_name ( gchar *name )
     return NULL;
   return g_hash_table_lookup(popup_list,name);
 }
+
+/* remove all popups ahead of a config reload */
+void popup_remove_all ( void )
+{
+  GHashTableIter iter;
+  void *name, *win;
+
+  if(!popup_list)
+    return;
+
+  g_hash_table_iter_init(&iter, popup_list);
+  while(g_hash_table_iter_next(&iter, &name, &win))
+  {
+    g_hash_table_iter_remove(&iter);
+    gtk_widget_destroy(win);
+    g_free(name);
+  }
+}
@@ -3,6 +3,7 @@
 
 GtkWidget *popup_new ( gchar *name );
 GtkWidget *popup_from_name ( gchar *name );
+void popup_remove_all ( void );
 void popup_trigger ( GtkWidget *parent, gchar *name, GdkEvent *ev );
 void popup_show ( GtkWidget *parent, GtkWidget *popup, GdkSeat *seat );
 void popup_get_gravity ( GtkWidget *widget, GdkGravity *, GdkGravity * );
@@ -6,12 +6,165 @@
 #include "sfwbar.h"
 #include "scaleimage.h"
 #include "appinfo.h"
+#include "metrics.h"
+#include "trace.h"
 #include <gtk/gtk.h>
 #include <gio/gdesktopappinfo.h>
+#include <glib/gstdio.h>
 
 G_DEFINE_TYPE_WITH_CODE (ScaleImage, scale_image, GTK_TYPE_IMAGE,
     G_ADD_PRIVATE (ScaleImage))
 
+/* rendered surfaces of icons, image files and svg data are shared by all
+ * scale images via a process wide cache, keyed by source (svg data by digest
+ * and foreground color, files by path, mtime and size), size, scale and
+ * symbolic state.
+ * The cache holds a reference to each surface and drops the least recently
+ * used ones once it grows beyond SCALE_IMAGE_CACHE_SIZE entries */
+#define SCALE_IMAGE_CACHE_SIZE 256
+#define SCALE_IMAGE_THREADS 2
+
+typedef struct scale_image_cache_entry {
+  gchar *key;
+  cairo_surface_t *cs;
+  gboolean fallback;
+  GList link;
+} si_cache_entry_t;
+
+typedef struct scale_image_waiter {
+  GtkWidget *self;
+  guint serial;
+  gint width, height;
+} si_waiter_t;
+
+typedef struct scale_image_job {
+  GList *waiters;
+  gint width, height;
+  gchar *key;
+  gchar *fname;
+  gchar *data;
+  const gchar *fallback;
+  GdkPixbuf *pixbuf;
+  gboolean is_fallback;
+} si_job_t;
+
+static GHashTable *si_cache;
+static GHashTable *si_pending;
+static GQueue si_cache_lru = G_QUEUE_INIT;
+static GThreadPool *si_pool;
+static gchar *si_fallback;
+static gboolean si_fallback_resolved;
+
+static void scale_image_cache_entry_free ( si_cache_entry_t *entry )
+{
+  g_queue_unlink(&si_cache_lru, &entry->link);
+  cairo_surface_destroy(entry->cs);
+  g_free(entry->key);
+  g_free(entry);
+}
+
+static void scale_image_cache_flush ( void )
+{
+  if(si_cache)
+    g_hash_table_remove_all(si_cache);
+}
+
+/* svg data is split on @theme_fg_color once, the template is re-joined
+ * with the current foreground color on each render */
+static gchar *scale_image_svg_color ( GtkWidget *self )
+{
+  ScaleImagePrivate *priv;
+  GdkRGBA col;
+
+  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
+
+  if(!priv->svg || !priv->svg[0] || !priv->svg[1])
+    return NULL;
+
+  gtk_style_context_get_color(gtk_widget_get_style_context(self),
+      GTK_STATE_FLAG_NORMAL, &col);
+  return g_strdup_printf("Rgba(%d,%d,%d,%f)", (gint)(col.red*256),
+      (gint)(col.green*256), (gint)(col.blue*256), col.alpha);
+}
+
+static gchar *scale_image_cache_key ( GtkWidget *self, gint w, gint h )
+{
+  ScaleImagePrivate *priv;
+  GStatBuf st;
+  gchar *color, *key;
+
+  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
+
+  if(priv->ftype == SI_DATA && priv->digest)
+  {
+    color = scale_image_svg_color(self);
+    key = g_strdup_printf("%d:%s:%s:%dx%d@%d", priv->ftype, priv->digest,
+        color?color:"", w, h, gtk_widget_get_scale_factor(self));
+    g_free(color);
+    return key;
+  }
+
+  if((priv->ftype != SI_ICON && priv->ftype != SI_FILE) || !priv->fname)
+    return NULL;
+
+  /* scripts may rewrite an image at a fixed path (i.e. cover art), so
+   * files are also keyed by modification time and size */
+  if(priv->ftype == SI_FILE)
+  {
+    if(g_stat(priv->fname, &st))
+      return NULL;
+    return g_strdup_printf("%d:%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT
+        ":%dx%d@%d:%d", priv->ftype, priv->fname, (gint64)st.st_mtime,
+        (gint64)st.st_size, w, h, gtk_widget_get_scale_factor(self),
+        priv->symbolic);
+  }
+
+  return g_strdup_printf("%d:%s:%dx%d@%d:%d", priv->ftype, priv->fname, w, h,
+      gtk_widget_get_scale_factor(self), priv->symbolic);
+}
+
+static si_cache_entry_t *scale_image_cache_lookup ( gchar *key )
+{
+  si_cache_entry_t *entry;
+
+  if(!si_cache || !key || !(entry = g_hash_table_lookup(si_cache, key)) )
+    return NULL;
+
+  g_queue_unlink(&si_cache_lru, &entry->link);
+  g_queue_push_head_link(&si_cache_lru, &entry->link);
+
+  return entry;
+}
+
+static void scale_image_cache_insert ( gchar *key, cairo_surface_t *cs,
+    gboolean fallback )
+{
+  si_cache_entry_t *entry;
+
+  if(!key || !cs)
+    return;
+
+  if(!si_cache)
+  {
+    si_cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        (GDestroyNotify)scale_image_cache_entry_free);
+    g_signal_connect(G_OBJECT(gtk_icon_theme_get_default()), "changed",
+        G_CALLBACK(scale_image_cache_flush), NULL);
+  }
+
+  entry = g_malloc0(sizeof(si_cache_entry_t));
+  entry->key = g_strdup(key);
+  entry->cs = cairo_surface_reference(cs);
+  entry->fallback = fallback;
+  entry->link.data = entry;
+  g_hash_table_replace(si_cache, entry->key, entry);
+  g_queue_push_head_link(&si_cache_lru, &entry->link);
+
+  while(g_queue_get_length(&si_cache_lru) > SCALE_IMAGE_CACHE_SIZE)
+    g_hash_table_remove(si_cache,
+        ((si_cache_entry_t *)g_queue_peek_tail(&si_cache_lru))->key);
+}
+
 static void scale_image_get_preferred_width ( GtkWidget *self, gint *m,
     gint *n )
 {
@@ -56,99 +209,226 @@ static void scale_image_get_preferred_height ( GtkWidget *self, gint *m,
   *n = *m;
 }
 
-static void scale_image_surface_update ( GtkWidget *self, gint w, gint h )
+/* images are decoded and scaled on a worker pool. The job carries everything
+ * the worker needs, so it doesn't touch the widget or gtk state. Images
+ * requesting a surface that is already being rendered wait on the pending
+ * job instead of queueing another one. The result is posted back to the main
+ * loop and only applied to the images that still want it, until then they
+ * keep painting their last good surface */
+static void scale_image_waiter_free ( si_waiter_t *waiter )
+{
+  g_object_unref(G_OBJECT(waiter->self));
+  g_free(waiter);
+}
+
+static void scale_image_job_free ( si_job_t *job )
+{
+  g_free(job->key);
+  g_free(job->fname);
+  g_free(job->data);
+  g_clear_pointer(&job->pixbuf, g_object_unref);
+  g_list_free_full(job->waiters, (GDestroyNotify)scale_image_waiter_free);
+  g_free(job);
+}
+
+static void scale_image_job_wait ( si_job_t *job, GtkWidget *self )
 {
   ScaleImagePrivate *priv;
-  GdkPixbuf *buf, *tmp;
-  GdkPixbufLoader *loader;
-  gchar *fallback;
-  gboolean aspect;
+  si_waiter_t *waiter;
 
   priv = scale_image_get_instance_private(SCALE_IMAGE(self));
-  priv->fallback = FALSE;
+  waiter = g_malloc0(sizeof(si_waiter_t));
+  waiter->self = g_object_ref(self);
+  waiter->serial = priv->serial;
+  waiter->width = priv->width;
+  waiter->height = priv->height;
+  job->waiters = g_list_prepend(job->waiters, waiter);
+}
 
-  if(priv->ftype == SI_ICON)
-    buf =  gtk_icon_theme_load_icon(gtk_icon_theme_get_default(),
-        priv->fname, MIN(w, h), 0, NULL);
+static gboolean scale_image_job_done ( si_job_t *job )
+{
+  ScaleImagePrivate *priv;
+  si_waiter_t *waiter;
+  cairo_surface_t *cs = NULL;
+  GList *iter;
 
-  else if(priv->ftype == SI_FILE && priv->fname)
-    buf = gdk_pixbuf_new_from_file_at_scale(priv->fname, w, h, TRUE, NULL);
+  if(job->key && si_pending)
+    g_hash_table_remove(si_pending, job->key);
 
-  else if(priv->ftype == SI_BUFF && priv->pixbuf)
-    buf = g_object_ref(priv->pixbuf);
+  waiter = job->waiters->data;
+  if(job->pixbuf)
+  {
+    cs = gdk_cairo_surface_create_from_pixbuf(job->pixbuf,
+        gtk_widget_get_scale_factor(waiter->self),
+        gtk_widget_get_window(waiter->self));
+    scale_image_cache_insert(job->key, cs, job->is_fallback);
+  }
 
-  else if (priv->ftype == SI_DATA && priv->file)
+  for(iter=job->waiters; iter; iter=g_list_next(iter))
   {
-    loader = gdk_pixbuf_loader_new();
-    gdk_pixbuf_loader_set_size(loader, w, h);
-    GdkRGBA col;
-    gtk_style_context_get_color(gtk_widget_get_style_context(self),
-        GTK_STATE_FLAG_NORMAL, &col);
-    gchar *svg;
-    gchar *rgba;
-    if(strstr(priv->file,"@theme_fg_color"))
+    waiter = iter->data;
+    priv = scale_image_get_instance_private(SCALE_IMAGE(waiter->self));
+    if(!gtk_widget_in_destruction(waiter->self) &&
+        waiter->serial == priv->serial && waiter->width == priv->width &&
+        waiter->height == priv->height)
     {
-      rgba = g_strdup_printf("Rgba(%d,%d,%d,%f)", (gint)(col.red*256),
-          (gint)(col.green*256), (gint)(col.blue*256), col.alpha);
-      svg = str_replace(priv->file, "@theme_fg_color", rgba);
-      g_free(rgba);
+      cairo_surface_destroy(priv->cs);
+      priv->cs = cs? cairo_surface_reference(cs) : NULL;
+      priv->fallback = job->is_fallback;
+      gtk_widget_queue_draw(waiter->self);
     }
-    else
-      svg = NULL;
-    gdk_pixbuf_loader_write(loader, (guchar *)(svg?svg:priv->file),
-        strlen(svg?svg:priv->file), NULL);
+  }
+  cairo_surface_destroy(cs);
+
+  scale_image_job_free(job);
+  return FALSE;
+}
+
+static void scale_image_job_run ( si_job_t *job, gpointer d )
+{
+  GdkPixbuf *buf, *tmp;
+  GdkPixbufLoader *loader;
+  gdouble aspect;
+  gint w, h;
+
+  w = job->width;
+  h = job->height;
+
+  if(job->pixbuf)
+    buf = g_object_ref(job->pixbuf);
+
+  else if(job->fname)
+    buf = gdk_pixbuf_new_from_file_at_scale(job->fname, w, h, TRUE, NULL);
+
+  else if(job->data)
+  {
+    loader = gdk_pixbuf_loader_new();
+    gdk_pixbuf_loader_set_size(loader, w, h);
+    gdk_pixbuf_loader_write(loader, (guchar *)job->data, strlen(job->data),
+        NULL);
     gdk_pixbuf_loader_close(loader, NULL);
     buf = gdk_pixbuf_loader_get_pixbuf(loader);
     if(buf)
       buf = gdk_pixbuf_copy(buf);
     g_object_unref(G_OBJECT(loader));
-    g_free(svg);
   }
   else
     buf = NULL;
 
-  if(!buf)
+  if(!buf && job->fallback)
   {
-    fallback = get_xdg_config_file("icons/misc/missing.svg", NULL);
-    if(fallback)
-    {
-      buf = gdk_pixbuf_new_from_file_at_scale(fallback, w, h, TRUE, NULL);
-      g_free(fallback);
-      priv->fallback = TRUE;
-    }
+    buf = gdk_pixbuf_new_from_file_at_scale(job->fallback, w, h, TRUE, NULL);
+    job->is_fallback = TRUE;
   }
 
   if(buf)
   {
-    aspect = (gboolean)gdk_pixbuf_get_width(buf) /
-      (gboolean)gdk_pixbuf_get_height(buf);
+    aspect = (gdouble)gdk_pixbuf_get_width(buf) /
+      (gdouble)gdk_pixbuf_get_height(buf);
 
-    if((gboolean)w/(gboolean)h > aspect)
-      w = (gboolean)h * aspect;
-    else if((gboolean)w/(gboolean)h < aspect)
-      h  = (gboolean)w / aspect;
+    if((gdouble)w/(gdouble)h > aspect)
+      w = (gdouble)h * aspect;
+    else if((gdouble)w/(gdouble)h < aspect)
+      h  = (gdouble)w / aspect;
   }
 
   if(buf && gdk_pixbuf_get_width(buf) != w &&
       gdk_pixbuf_get_height(buf) != h)
   {
     tmp = buf;
-    buf = gdk_pixbuf_scale_simple(tmp, w, h, GDK_INTERP_BILINEAR);
+    buf = gdk_pixbuf_scale_simple(tmp, MAX(w, 1), MAX(h, 1),
+        GDK_INTERP_BILINEAR);
     g_object_unref(G_OBJECT(tmp));
   }
 
-  cairo_surface_destroy(priv->cs); 
-  if(!buf)
+  g_clear_pointer(&job->pixbuf, g_object_unref);
+  job->pixbuf = buf;
+  g_main_context_invoke(NULL, (GSourceFunc)scale_image_job_done, job);
+}
+
+static void scale_image_surface_update ( GtkWidget *self, gint w, gint h )
+{
+  ScaleImagePrivate *priv;
+  GtkIconInfo *info;
+  si_cache_entry_t *entry;
+  si_job_t *job;
+  gchar *key, *color;
+
+  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
+  priv->width = w;
+  priv->height = h;
+  priv->cs_serial = priv->serial;
+
+  key = scale_image_cache_key(self, w, h);
+  if( (entry = scale_image_cache_lookup(key)) )
   {
-    priv->cs = NULL;
+    METRICS_INC(surface_cache_hits);
+    cairo_surface_destroy(priv->cs);
+    priv->cs = cairo_surface_reference(entry->cs);
+    priv->fallback = entry->fallback;
+    g_free(key);
     return;
   }
+  METRICS_INC(surface_cache_misses);
 
-  priv->width = w;
-  priv->height = h;
-  priv->cs = gdk_cairo_surface_create_from_pixbuf(buf, 0,
-      gtk_widget_get_window(self));
-  g_object_unref(G_OBJECT(buf));
+  if(key && si_pending && (job = g_hash_table_lookup(si_pending, key)) )
+  {
+    scale_image_job_wait(job, self);
+    g_free(key);
+    return;
+  }
+
+  job = g_malloc0(sizeof(si_job_t));
+  job->width = w;
+  job->height = h;
+  job->key = key;
+  scale_image_job_wait(job, self);
+
+  if(priv->ftype == SI_ICON && priv->fname)
+  {
+    if( (info = gtk_icon_theme_lookup_icon(gtk_icon_theme_get_default(),
+          priv->fname, MIN(w, h), 0)) )
+    {
+      /* builtin icons have no file and are loaded here */
+      if( !(job->fname = g_strdup(gtk_icon_info_get_filename(info))) )
+        job->pixbuf = gtk_icon_info_load_icon(info, NULL);
+      g_object_unref(G_OBJECT(info));
+    }
+  }
+
+  else if(priv->ftype == SI_FILE && priv->fname)
+    job->fname = g_strdup(priv->fname);
+
+  else if(priv->ftype == SI_BUFF && priv->pixbuf)
+    job->pixbuf = g_object_ref(priv->pixbuf);
+
+  else if (priv->ftype == SI_DATA && priv->file)
+  {
+    if( (color = scale_image_svg_color(self)) )
+      job->data = g_strjoinv(color, priv->svg);
+    else
+      job->data = g_strdup(priv->file);
+    g_free(color);
+  }
+
+  if(!si_fallback_resolved)
+  {
+    si_fallback = get_xdg_config_file("icons/misc/missing.svg", NULL);
+    si_fallback_resolved = TRUE;
+  }
+  job->fallback = si_fallback;
+
+  if(key)
+  {
+    if(!si_pending)
+      si_pending = g_hash_table_new(g_str_hash, g_str_equal);
+    g_hash_table_insert(si_pending, job->key, job);
+  }
+
+  if(!si_pool)
+    si_pool = g_thread_pool_new((GFunc)scale_image_job_run, NULL,
+        SCALE_IMAGE_THREADS, FALSE, NULL);
+  g_thread_pool_push(si_pool, job, NULL);
 }
 
 static gboolean scale_image_draw ( GtkWidget *self, cairo_t *cr )
@@ -160,6 +440,7 @@ static gboolean scale_image_draw ( GtkWidget *self, cairo_t *cr )
   GtkBorder border, padding, margin;
   gint width, height, scale;
   gdouble x_origin, y_origin;
+  gint64 trace;
 
   g_return_val_if_fail(IS_SCALE_IMAGE(self),-1);
   priv = scale_image_get_instance_private(SCALE_IMAGE(self));
@@ -187,8 +468,13 @@ static gboolean scale_image_draw ( GtkWidget *self, cairo_t *cr )
   if( width < 1 || height < 1 )
     return FALSE;
 
-  if(!priv->cs || priv->width != width || priv->height != height )
+  if(priv->cs_serial != priv->serial || priv->width != width ||
+      priv->height != height )
+  {
+    trace = TRACE_BEGIN();
     scale_image_surface_update(self,width,height);
+    TRACE_END(trace, "widget", "scale_image_surface_update");
+  }
 
   if(!priv->cs)
     return FALSE;
@@ -236,15 +522,21 @@ static void scale_image_clear ( GtkWidget *self )
   g_clear_pointer(&priv->file,g_free);
   g_clear_pointer(&priv->extra,g_free);
   g_clear_pointer(&priv->pixbuf,g_object_unref);
-  g_clear_pointer(&priv->cs,cairo_surface_destroy);
+  g_clear_pointer(&priv->svg,g_strfreev);
+  g_clear_pointer(&priv->digest,g_free);
   priv->ftype = SI_NONE;
+  priv->serial++;
 }
 
 static void scale_image_destroy ( GtkWidget *self )
 {
+  ScaleImagePrivate *priv;
+
   g_return_if_fail(IS_SCALE_IMAGE(self));
+  priv = scale_image_get_instance_private(SCALE_IMAGE(self));
 
   scale_image_clear(self);
+  g_clear_pointer(&priv->cs,cairo_surface_destroy);
   GTK_WIDGET_CLASS(scale_image_parent_class)->destroy(self);
 }
 
@@ -253,6 +545,7 @@ static void scale_image_style_updated ( GtkWidget *self )
   ScaleImagePrivate *priv;
   gboolean prefer_symbolic;
   gchar *image, *extra;
+  GdkRGBA color;
 
   g_return_if_fail(IS_SCALE_IMAGE(self));
   priv = scale_image_get_instance_private(SCALE_IMAGE(self));
@@ -267,6 +560,17 @@ static void scale_image_style_updated ( GtkWidget *self )
     g_free(image);
     g_free(extra);
   }
+  /* theme colored svg's need to be rendered again if the color changed */
+  if(priv->ftype == SI_DATA && priv->svg && priv->svg[0] && priv->svg[1])
+  {
+    gtk_style_context_get_color(gtk_widget_get_style_context(self),
+        GTK_STATE_FLAG_NORMAL, &color);
+    if(!gdk_rgba_equal(&color, &priv->color))
+    {
+      priv->color = color;
+      priv->serial++;
+    }
+  }
   GTK_WIDGET_CLASS(scale_image_parent_class)->style_updated(self);
 }
 
@@ -298,9 +602,13 @@ static void scale_image_init ( ScaleImage *self )
   priv->file = NULL;
   priv->fname = NULL;
   priv->pixbuf = NULL;
+  priv->svg = NULL;
+  priv->digest = NULL;
   priv->cs = NULL;
   priv->width = 0;
   priv->height = 0;
+  priv->serial = 1;
+  priv->cs_serial = 0;
   priv->fallback = FALSE;
   priv->ftype = SI_NONE;
 }
@@ -321,7 +629,7 @@ void scale_image_set_pixbuf ( GtkWidget *self, GdkPixbuf *pb )
     return;
 
   scale_image_clear(self);
-  priv->pixbuf = gdk_pixbuf_copy(pb);
+  priv->pixbuf = g_object_ref(pb);
   priv->ftype = SI_BUFF;
   gtk_widget_queue_draw(self);
 }
@@ -341,18 +649,24 @@ gboolean scale_image_set_image ( GtkWidget *self, const gchar *image,
   if(!image)
     return FALSE;
 
-  if( !g_strcmp0(priv->file, image) && !g_strcmp0(priv->extra, extra) )
+  /* retry images not found, once the app info index has been updated */
+  if( !g_strcmp0(priv->file, image) && !g_strcmp0(priv->extra, extra) &&
+      (priv->ftype != SI_NONE || priv->appinfo_serial == app_info_get_serial()) )
     return (priv->ftype != SI_NONE);
 
   scale_image_clear(self);
   priv->file = g_strdup(image);
   priv->extra = g_strdup(extra);
+  priv->appinfo_serial = app_info_get_serial();
   priv->symbolic = FALSE;
   gtk_widget_queue_draw(self);
 
   if(!g_ascii_strncasecmp(priv->file, "<?xml", 5))
   {
     priv->ftype = SI_DATA;
+    priv->svg = g_strsplit(priv->file, "@theme_fg_color", -1);
+    priv->digest = g_compute_checksum_for_string(G_CHECKSUM_SHA1, priv->file,
+        -1);
     return TRUE;
   }
 
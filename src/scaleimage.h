@@ -28,12 +28,17 @@ struct _ScaleImagePrivate
 {
   gint ftype;
   gint width, height;
+  guint serial, cs_serial;
+  guint appinfo_serial;
   gboolean fallback;
   gboolean symbolic;
   gboolean symbolic_pref;
   gchar *file;
   gchar *extra;
   gchar *fname;
+  gchar **svg;
+  gchar *digest;
+  GdkRGBA color;
   GdkPixbuf *pixbuf;
   cairo_surface_t *cs;
 };
@@ -11,6 +11,8 @@
 #include "expr.h"
 #include "config.h"
 #include "client.h"
+#include "trace.h"
+#include "metrics.h"
 
 static GList *file_list;
 static GHashTable *scan_list;
@@ -38,12 +40,17 @@ ScanFile *scanner_file_new ( gint source, gchar *fname,
   ScanFile *file;
   GList *iter;
 
-  if(source == SO_CLIENT)
-    iter = NULL;
-  else
-    for(iter=file_list;iter;iter=g_list_next(iter))
-      if(!g_strcmp0(fname,((ScanFile *)(iter->data))->fname))
-        break;
+  /* clients may rewrite fname once connected, so they are matched by the
+   * definition they were created from. This keeps config reloads from
+   * starting another client for each source */
+  for(iter=file_list;iter;iter=g_list_next(iter))
+  {
+    file = iter->data;
+    if((source == SO_CLIENT) != (file->source == SO_CLIENT))
+      continue;
+    if(!g_strcmp0(fname, source==SO_CLIENT? file->definition : file->fname))
+      break;
+  }
 
   if(iter)
   {
@@ -55,6 +62,8 @@ ScanFile *scanner_file_new ( gint source, gchar *fname,
     file = g_malloc0(sizeof(ScanFile));
     file_list = g_list_append(file_list,file);
     file->fname = fname;
+    if(source == SO_CLIENT)
+      file->definition = g_strdup(fname);
   }
 
   file->source = source;
@@ -221,15 +230,20 @@ GIOStatus scanner_file_update ( GIOChannel *in, ScanFile *file, gsize *size )
   gchar *read_buff;
   GIOStatus status;
   gsize lsize;
+  gint64 start, elapsed;
+  guint64 bytes = 0;
+  guint matches = 0;
 
   if(size)
     *size = 0;
 
+  start = METRICS_NOW();
   while((status = g_io_channel_read_line(in,&read_buff,&lsize,NULL,NULL))
       ==G_IO_STATUS_NORMAL)
   {
     if(size)
       *size += lsize;
+    bytes += lsize;
     for(node=file->vars;node!=NULL;node=g_list_next(node))
     {
       var=node->data;
@@ -238,7 +252,10 @@ GIOStatus scanner_file_update ( GIOChannel *in, ScanFile *file, gsize *size )
         case G_TOKEN_REGEX:
           if(var->definition &&
               g_regex_match (var->definition, read_buff, 0, &match))
+          {
+            matches++;
             scanner_var_values_update(var,g_match_info_fetch (match, 1));
+          }
           if(match)
             g_match_info_free (match);
           break;
@@ -273,6 +290,21 @@ GIOStatus scanner_file_update ( GIOChannel *in, ScanFile *file, gsize *size )
     ((ScanVar *)node->data)->vstate = TRUE;
   }
 
+  elapsed = METRICS_NOW() - start;
+#if METRICS
+  /* clients are read on the main thread and files on the scanner thread, so
+   * each source has a single writer and the dump accepts racy reads */
+  file->reads++;
+  file->bytes += bytes;
+  file->matches += matches;
+  file->read_time += elapsed;
+  file->read_max = MAX(file->read_max, elapsed);
+#else
+  (void)elapsed;
+  (void)bytes;
+  (void)matches;
+#endif
+
   g_debug("channel status %d, (%s)",status,file->fname?file->fname:"(null)");
 
   return status;
@@ -302,6 +334,13 @@ time_t scanner_file_mtime ( glob_t *gbuf )
   return res;
 }
 
+#if METRICS
+void scanner_file_spawned ( ScanFile *file )
+{
+  file->spawns++;
+}
+#endif
+
 gboolean scanner_file_exec ( ScanFile *file )
 {
   GIOChannel *chan;
@@ -314,6 +353,7 @@ gboolean scanner_file_exec ( ScanFile *file )
   if(!g_spawn_async_with_pipes(NULL,argv,NULL,G_SPAWN_SEARCH_PATH,NULL,NULL,
         NULL, NULL, &out, NULL, NULL))
     return FALSE;
+  scanner_file_spawned(file);
 
   chan = g_io_channel_unix_new(out);
   if(chan)
@@ -411,6 +451,7 @@ gchar *scanner_parse_identifier ( gchar *id, gchar **fname )
 ScanVar *scanner_var_update ( gchar *name, gboolean update, ExprCache *expr )
 {
   ScanVar *var;
+  gint64 trace;
 
   if(!scan_list)
     return NULL;
@@ -443,7 +484,9 @@ ScanVar *scanner_var_update ( gchar *name, gboolean update, ExprCache *expr )
   }
   else
   {
+    trace = TRACE_BEGIN();
     scanner_file_glob(var->file);
+    TRACE_END(trace, "scanner", "scanner_file_glob");
     expr->vstate = TRUE;
     var->vstate = TRUE;
   }
@@ -502,6 +545,11 @@ void *scanner_get_value ( gchar *ident, gboolean update, ExprCache *expr )
   return retval;
 }
 
+guint scanner_var_count ( void )
+{
+  return scan_list? g_hash_table_size(scan_list) : 0;
+}
+
 gboolean scanner_is_variable ( gchar *identifier )
 {
   gchar *name;
@@ -516,3 +564,36 @@ gboolean scanner_is_variable ( gchar *identifier )
 
   return result;
 }
+
+#if METRICS
+static gint scanner_profile_comp ( ScanFile *f1, ScanFile *f2 )
+{
+  return f1->read_time < f2->read_time? 1 :
+    (f1->read_time > f2->read_time? -1 : 0);
+}
+
+/* print sources with the highest cumulative read time */
+void scanner_profile_dump ( gint count )
+{
+  GList *list, *iter;
+  ScanFile *file;
+  gint i;
+
+  list = g_list_sort(g_list_copy(file_list),
+      (GCompareFunc)scanner_profile_comp);
+
+  g_message("profile: %8s %6s %10s %8s %10s %8s  source", "reads", "spawns",
+      "bytes", "matches", "total ms", "max ms");
+  for(iter=list, i=0; iter && i<count; iter=g_list_next(iter), i++)
+  {
+    file = iter->data;
+    if(!file->reads)
+      break;
+    g_message("profile: %8u %6u %10" G_GUINT64_FORMAT
+        " %8u %10.1f %8.2f  %.60s", file->reads, file->spawns, file->bytes, file->matches,
+        file->read_time/1000.0, file->read_max/1000.0,
+        file->fname?file->fname:"(client)");
+  }
+  g_list_free(list);
+}
+#endif
@@ -24,12 +24,18 @@ enum {
 
 typedef struct scan_file {
   gchar *fname;
+  gchar *definition;
   const gchar *trigger;
   gint flags;
   guchar source;
   time_t mtime;
   GList *vars;
   void *client;
+#if METRICS
+  guint reads, spawns, matches;
+  guint64 bytes;
+  gint64 read_time, read_max;
+#endif
 } ScanFile;
 
 typedef struct scan_var {
@@ -60,6 +66,13 @@ gchar *scanner_parse_identifier ( gchar *id, gchar **fname );
 ScanFile *scanner_file_get ( gchar *trigger );
 ScanFile *scanner_file_new ( gint , gchar *, gchar *, gint );
 gboolean scanner_is_variable ( gchar *identifier );
+guint scanner_var_count ( void );
 void scanner_file_attach ( const gchar *trigger, ScanFile *file );
+#if METRICS
+void scanner_file_spawned ( ScanFile *file );
+void scanner_profile_dump ( gint count );
+#else
+#define scanner_file_spawned(file) ((void)(file))
+#endif
 
 #endif
@@ -16,6 +16,10 @@
 #include "sway_ipc.h"
 #include "expr.h"
 #include "appinfo.h"
+#include "popup.h"
+#include "menu.h"
+#include "trace.h"
+#include "metrics.h"
 
 extern gchar *confname;
 extern gchar *sockname;
@@ -25,9 +29,10 @@ static gchar *cssname;
 static gchar *monitor;
 static gchar *bar_id;
 static gchar *dfilter;
+static gchar *trace_startup;
+static gchar *metrics_path;
 static GRegex *rfilter;
 static gboolean debug = FALSE;
-static gchar **sargv;
 
 static GOptionEntry entries[] = {
   {"config",'f',0,G_OPTION_ARG_FILENAME,&confname,"Specify config file"},
@@ -39,6 +44,10 @@ static GOptionEntry entries[] = {
     "Monitor to display the panel on (use \"-m list\" to list monitors`"},
   {"bar_id",'b',0,G_OPTION_ARG_STRING,&bar_id,
     "default sway bar_id to listen on for sway events"},
+  {"trace-startup",0,0,G_OPTION_ARG_FILENAME,&trace_startup,
+    "Record startup timeline to a json file (use \"-\" to print a summary)"},
+  {"metrics",0,0,G_OPTION_ARG_FILENAME,&metrics_path,
+    "Serve runtime metrics on a unix socket"},
   {NULL}};
 
 void parse_command_line ( gint argc, gchar **argv)
@@ -94,45 +103,92 @@ void log_print ( const gchar *log_domain, GLogLevelFlags log_level,
   g_date_time_unref(now);
 }
 
-gboolean shell_timer ( gpointer data )
+static void sfwbar_bars_init ( void )
 {
-  taskbar_update_all();
-  switcher_update();
-  pager_update_all();
-  tray_update();
+  GList *clist, *iter;
 
-  return TRUE;
+  clist = gtk_window_list_toplevels();
+  for(iter = clist; iter; iter = g_list_next(iter) )
+    if(GTK_IS_BOX(gtk_bin_get_child(GTK_BIN(iter->data))))
+    {
+      css_widget_cascade(GTK_WIDGET(iter->data),NULL);
+      base_widget_autoexec(iter->data,NULL);
+      if(monitor)
+        bar_set_monitor(iter->data, monitor);
+      trace_startup_watch(iter->data);
+    }
+  g_list_free(clist);
 }
 
-static gboolean sfwbar_restart ( gpointer d )
+/* reload the config in place. Loaded modules, ipc connections, client
+ * sources, the window tree, tray items, scanner variables and caches are
+ * kept. If only css changed, widgets are restyled, otherwise the layout,
+ * bar settings, the switcher and the window filters and maps are rebuilt
+ * from the config */
+static gboolean sfwbar_reload ( gpointer d )
 {
-  gint i, fdlimit;
-
-  fdlimit = (int)sysconf(_SC_OPEN_MAX);
-  g_debug("reload: closing fd's %d to %d",STDERR_FILENO+1,fdlimit);
-  for(i=STDERR_FILENO+1; i<fdlimit; i++)
-    fcntl(i,F_SETFD,FD_CLOEXEC);
-  g_debug("reload: exec: %s",sargv[0]);
-  execvp(sargv[0],sargv);
-  exit(1);
-  return FALSE;
+  GList *clist;
+  gboolean restyle;
+
+  restyle = css_reload();
+
+  if(!config_files_changed())
+  {
+    g_debug("reload: config unchanged%s", restyle?", restyling":"");
+    if(restyle)
+    {
+      clist = gtk_window_list_toplevels();
+      g_list_foreach(clist, (GFunc)css_widget_cascade, NULL);
+      g_list_free(clist);
+    }
+    return TRUE;
+  }
+
+  g_debug("reload: rebuilding layout");
+  bar_layout_clear();
+  switcher_destroy();
+  popup_remove_all();
+  menu_remove_all();
+  action_config_clear();
+  wintree_config_clear();
+
+  config_parse(confname?confname:"sfwbar.config",TRUE);
+
+  bar_layout_finish();
+  sfwbar_bars_init();
+  action_function_exec("SfwBarInit",NULL,NULL,NULL,NULL);
+  bar_settings_finish();
+  taskbar_populate();
+  switcher_populate();
+
+  return TRUE;
 }
 
 static void activate (GtkApplication* app, gpointer data )
 {
   GdkDisplay *gdisp;
-  GList *clist, *iter;
+  GList *clist;
+  gint64 t;
 
+  t = trace_startup_end(trace_startup_origin(), "init", "gtk");
   application = app;
   config_init();
+  t = trace_startup_end(t, "init", "config_init");
   expr_lib_init();
   action_lib_init();
+  t = trace_startup_end(t, "init", "expr_lib_init/action_lib_init");
   css_init(cssname);
+  t = trace_startup_end(t, "init", "css_init");
   wayland_init();
+  t = trace_startup_end(t, "init", "wayland_init");
   sway_ipc_init();
+  t = trace_startup_end(t, "ipc", "sway_ipc_init");
   hypr_ipc_init();
+  t = trace_startup_end(t, "ipc", "hypr_ipc_init");
   wayland_ipc_init();
+  t = trace_startup_end(t, "ipc", "wayland_ipc_init");
   app_info_init();
+  t = trace_startup_end(t, "init", "app_info_init");
 
   if( monitor && !g_ascii_strcasecmp(monitor,"list") )
     list_monitors();
@@ -141,22 +197,19 @@ static void activate (GtkApplication* app, gpointer data )
     bar_address_all(NULL, bar_id, bar_set_id);
 
   config_parse(confname?confname:"sfwbar.config",TRUE);
+  t = trace_startup_begin();
 
   clist = gtk_window_list_toplevels();
 
   if(!clist && !switcher_state() && !wintree_placer_state())
     g_error("Configuration file doesn't specify any features");
-
-  for(iter = clist; iter; iter = g_list_next(iter) )
-    if(GTK_IS_BOX(gtk_bin_get_child(GTK_BIN(iter->data))))
-    {
-      css_widget_cascade(GTK_WIDGET(iter->data),NULL);
-      base_widget_autoexec(iter->data,NULL);
-      if(monitor)
-        bar_set_monitor(iter->data, monitor);
-    }
+  if(!clist)
+    g_idle_add(trace_startup_done, NULL);
   g_list_free(clist);
 
+  sfwbar_bars_init();
+  t = trace_startup_end(t, "init", "bars_init");
+
   gdisp = gdk_display_get_default();
   g_signal_connect(gdisp, "monitor-added",
       G_CALLBACK(bar_monitor_added_cb),NULL);
@@ -168,28 +221,27 @@ static void activate (GtkApplication* app, gpointer data )
         g_main_context_get_thread_default()));
 
   action_function_exec("SfwBarInit",NULL,NULL,NULL,NULL);
+  t = trace_startup_end(t, "init", "SfwBarInit");
   taskbar_populate();
   switcher_populate();
+  trace_startup_end(t, "init", "taskbar/switcher populate");
 
-  g_timeout_add (100,(GSourceFunc )shell_timer,NULL);
   g_unix_signal_add(SIGUSR1,(GSourceFunc)switcher_event,NULL);
   g_unix_signal_add(SIGUSR2,(GSourceFunc)bar_visibility_toggle_all,NULL);
-  g_unix_signal_add(SIGHUP,(GSourceFunc)sfwbar_restart,NULL);
+  g_unix_signal_add(SIGHUP,(GSourceFunc)sfwbar_reload,NULL);
+  metrics_init(metrics_path);
 }
 
 int main (int argc, gchar **argv)
 {
   GtkApplication *app;
-  gint status, i;
-
-  sargv = g_malloc0(sizeof(gchar *)*(argc+1));
-  for(i=0; i<argc; i++)
-    sargv[i] = argv[i];
+  gint status;
 
   signal_subscribe();
   g_log_set_handler(NULL,G_LOG_LEVEL_MASK,log_print,NULL);
 
   parse_command_line(argc,argv);
+  trace_startup_init(trace_startup);
 
   if(dfilter)
     rfilter = g_regex_new(dfilter,0,0,NULL);
@@ -18,6 +18,8 @@ enum ipc_type {
 
 void css_init ( gchar * );
 void css_file_load ( gchar * );
+void css_data_load ( const gchar *name, gchar *data );
+gboolean css_reload ( void );
 void css_widget_apply ( GtkWidget *widget, gchar *css );
 void css_widget_cascade ( GtkWidget *widget, gpointer data );
 void css_add_class ( GtkWidget *widget, gchar *css_class );
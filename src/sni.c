@@ -330,8 +330,11 @@ static void sni_register ( gchar *name )
 
 void sni_init ( void )
 {
-  if(!sni_get_connection())
+  static gboolean registered;
+
+  if(registered || !sni_get_connection())
     return;
+  registered = TRUE;
   sni_register("kde");
   sni_register("freedesktop");
 }
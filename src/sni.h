@@ -49,11 +49,14 @@ typedef struct sni_item {
   gchar *path;
   gchar *string[SNI_MAX_STRING];
   gchar *menu_path;
-  GdkPixbuf *pixbuf[3];
+  GHashTable *pixbuf[3];
+  GVariant *pixmap[3];
   gboolean menu;
   gboolean dirty;
   gint ref;
   guint signal;
+  guint timer;
+  guint32 pending;
   guint32 order;
   GCancellable *cancel;
   SniHost *host;
@@ -66,5 +69,6 @@ void sni_get_menu ( GtkWidget *widget, GdkEvent *event );
 SniItem *sni_item_new (GDBusConnection *, SniHost *, const gchar *);
 void sni_item_free ( SniItem *sni );
 GList *sni_item_get_list ( void );
+GdkPixbuf *sni_item_get_pixbuf ( SniItem *sni, guint idx, gint size );
 
 #endif
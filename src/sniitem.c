@@ -12,12 +12,26 @@
 #include "tray.h"
 #include "scaleimage.h"
 
+#define SNI_ITEM_DEBOUNCE 16
+#define SNI_PIXBUF_CACHE_SIZE 32
+#define SNI_PROP_ALL SNI_MAX_PROP
+
+typedef struct sni_prop_batch {
+  SniItem *sni;
+  gint count;
+  gboolean changed;
+} sni_batch_t;
+
 struct sni_prop_wrapper {
   guint prop;
-  SniItem *sni;
+  sni_batch_t *batch;
 };
 
 static GList *sni_items;
+static GHashTable *sni_pixbuf_cache;
+
+static void sni_item_get_props ( GDBusConnection *, SniItem *, guint32 );
+static gboolean sni_item_pixbuf_unused ( gchar *, GdkPixbuf *, gpointer );
 
 static gchar *sni_properties[] = { "Category", "Id", "Title", "Status",
   "IconName", "OverlayIconName", "AttentionIconName", "AttentionMovieName",
@@ -25,126 +39,308 @@ static gchar *sni_properties[] = { "Category", "Id", "Title", "Status",
   "OverlayIconPixmap", "AttentionIconPixmap", "ToolTip", "WindowId",
   "ItemIsMenu", "Menu", "XAyatanaOrderingIndex" };
 
-GdkPixbuf *sni_item_get_pixbuf ( GVariant *v )
+/* convert big endian ARGB pixels to RGBA bytes, the loop has no
+ * dependencies between iterations so the compiler can vectorize it.
+ * Items send straight (not premultiplied) alpha, as GdkPixbuf expects */
+static void sni_item_argb_to_rgba ( guchar * restrict dst,
+    const guchar * restrict src, gsize n )
+{
+  gsize i;
+
+  for(i=0; i<n*4; i+=4)
+  {
+    dst[i] = src[i+1];
+    dst[i+1] = src[i+2];
+    dst[i+2] = src[i+3];
+    dst[i+3] = src[i];
+  }
+}
+
+static GdkPixbuf *sni_item_pixmap_convert ( gint32 x, gint32 y,
+    const guchar *data, gsize len )
 {
-  gint32 x,y;
-  guint32 *ptr;
-  cairo_surface_t *cs;
   GdkPixbuf *res;
-  gint i;
-  GVariant *img,*child;
-  gsize len;
+  gchar *digest, *key;
+  guchar *pixels;
+  gint i, stride;
 
-  if(!v || !g_variant_check_format_string(v,"a(iiay)",FALSE) ||
-      g_variant_n_children(v) < 1)
-    return NULL;
+  digest = g_compute_checksum_for_data(G_CHECKSUM_MD5, data, len);
+  key = g_strdup_printf("%dx%d:%s", x, y, digest);
+  g_free(digest);
 
-  child = g_variant_get_child_value(v,0);
+  if(!sni_pixbuf_cache)
+    sni_pixbuf_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, g_object_unref);
 
-  g_variant_get(child,"(ii@ay)",&x,&y,&img);
-  ptr = (guint32 *)g_variant_get_fixed_array(img,&len,sizeof(guchar));
+  if( (res = g_hash_table_lookup(sni_pixbuf_cache, key)) )
+  {
+    g_free(key);
+    return g_object_ref(res);
+  }
 
-  if(!len || !ptr || len != x*y*4)
+  if( !(res = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, x, y)) )
   {
-    g_variant_unref(img);
-    g_variant_unref(child);
+    g_free(key);
     return NULL;
   }
+  pixels = gdk_pixbuf_get_pixels(res);
+  stride = gdk_pixbuf_get_rowstride(res);
+  for(i=0; i<y; i++)
+    sni_item_argb_to_rgba(pixels + i*stride, data + i*x*4, x);
 
-  ptr = g_memdup2(ptr,len);
-  g_variant_unref(img);
-  g_variant_unref(child);
-  for(i=0;i<x*y;i++)
-    ptr[i] = g_ntohl(ptr[i]);
-
-  cs = cairo_image_surface_create_for_data((guchar *)ptr,CAIRO_FORMAT_ARGB32,x,y,
-      cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32,x));
-  res = gdk_pixbuf_get_from_surface(cs,0,0,x,y);
-  cairo_surface_destroy(cs);
-  g_free(ptr);
-  g_object_ref_sink(G_OBJECT(res));
+  /* drop pixbufs no longer used by any item before adding a new one, if
+   * all of them are still in use, the new one isn't cached */
+  if(g_hash_table_size(sni_pixbuf_cache) >= SNI_PIXBUF_CACHE_SIZE)
+    g_hash_table_foreach_remove(sni_pixbuf_cache,
+        (GHRFunc)sni_item_pixbuf_unused, NULL);
+  if(g_hash_table_size(sni_pixbuf_cache) < SNI_PIXBUF_CACHE_SIZE)
+    g_hash_table_insert(sni_pixbuf_cache, key, g_object_ref(res));
+  else
+    g_free(key);
 
   return res;
 }
 
-void sni_item_prop_cb ( GDBusConnection *con, GAsyncResult *res,
-    struct sni_prop_wrapper *wrap)
+static gboolean sni_item_pixbuf_unused ( gchar *key, GdkPixbuf *pb,
+    gpointer d )
 {
-  GVariant *result, *inner;
+  return G_OBJECT(pb)->ref_count == 1;
+}
 
-  wrap->sni->ref--;
+/* pick the smallest pixmap covering the requested size or the largest
+ * one if none is large enough. The result is kept per size, so mirrored
+ * trays with different icon sizes don't evict each other */
+GdkPixbuf *sni_item_get_pixbuf ( SniItem *sni, guint idx, gint size )
+{
+  GVariantIter iter;
+  GVariant *img, *best = NULL;
+  const guchar *data;
+  gint32 x, y, bx = 0, by = 0;
+  GdkPixbuf *res;
+  gsize len;
 
-  result = g_dbus_connection_call_finish(con, res, NULL);
-  if(result)
-  {
-    g_variant_get(result, "(v)",&inner);
-    g_variant_unref(result);
-  }
+  if(!sni->pixmap[idx])
+    return NULL;
+
+  if(!sni->pixbuf[idx])
+    sni->pixbuf[idx] = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, g_object_unref);
+  else if( (res = g_hash_table_lookup(sni->pixbuf[idx],
+          GINT_TO_POINTER(size))) )
+    return res;
 
-  if(!result || !inner)
+  g_variant_iter_init(&iter, sni->pixmap[idx]);
+  while(g_variant_iter_next(&iter, "(ii@ay)", &x, &y, &img))
   {
-    g_free(wrap);
-    return;
+    if(x>0 && y>0 && g_variant_get_size(img) == (gsize)x*y*4 && (!best ||
+          (MAX(bx, by) < size && MAX(x, y) > MAX(bx, by)) ||
+          (MAX(x, y) >= size && MAX(x, y) < MAX(bx, by))))
+    {
+      if(best)
+        g_variant_unref(best);
+      best = img;
+      bx = x;
+      by = y;
+    }
+    else
+      g_variant_unref(img);
   }
 
-  if(wrap->prop<=SNI_PROP_THEME &&
+  if(!best)
+    return NULL;
+
+  data = g_variant_get_fixed_array(best, &len, sizeof(guchar));
+  res = sni_item_pixmap_convert(bx, by, data, len);
+  g_variant_unref(best);
+  if(res)
+    g_hash_table_insert(sni->pixbuf[idx], GINT_TO_POINTER(size), res);
+
+  return res;
+}
+
+static void sni_item_set_prop ( SniItem *sni, guint prop, GVariant *inner )
+{
+  if(prop<=SNI_PROP_THEME &&
       g_variant_is_of_type(inner,G_VARIANT_TYPE_STRING))
   {
-    g_free(wrap->sni->string[wrap->prop]);
-    g_variant_get(inner,"s",&(wrap->sni->string[wrap->prop]));
-    g_debug("sni %s: property %s = %s",wrap->sni->dest,
-        sni_properties[wrap->prop],wrap->sni->string[wrap->prop]);
+    g_free(sni->string[prop]);
+    g_variant_get(inner,"s",&(sni->string[prop]));
+    g_debug("sni %s: property %s = %s",sni->dest,
+        sni_properties[prop],sni->string[prop]);
   }
-  else if((wrap->prop>=SNI_PROP_ICONPIX)&&(wrap->prop<=SNI_PROP_ATTNPIX))
+  else if((prop>=SNI_PROP_ICONPIX)&&(prop<=SNI_PROP_ATTNPIX) &&
+      g_variant_is_of_type(inner,G_VARIANT_TYPE("a(iiay)")))
   {
-    if(wrap->sni->pixbuf[wrap->prop-SNI_PROP_ICONPIX])
-      g_object_unref(wrap->sni->pixbuf[wrap->prop-SNI_PROP_ICONPIX]);
-    wrap->sni->pixbuf[wrap->prop-SNI_PROP_ICONPIX] =
-      sni_item_get_pixbuf(inner);
-      g_debug("sni %s: property %s received",wrap->sni->dest,
-          sni_properties[wrap->prop]);
+    g_clear_pointer(&sni->pixmap[prop-SNI_PROP_ICONPIX], g_variant_unref);
+    g_clear_pointer(&sni->pixbuf[prop-SNI_PROP_ICONPIX],
+        g_hash_table_destroy);
+    sni->pixmap[prop-SNI_PROP_ICONPIX] = g_variant_ref(inner);
+      g_debug("sni %s: property %s received",sni->dest,
+          sni_properties[prop]);
   }
-  else if(wrap->prop == SNI_PROP_MENU &&
+  else if(prop == SNI_PROP_MENU &&
       g_variant_is_of_type(inner,G_VARIANT_TYPE_OBJECT_PATH))
     {
-      g_free(wrap->sni->menu_path);
-      g_variant_get(inner,"o",&(wrap->sni->menu_path));
-      g_debug("sni %s: property %s = %s",wrap->sni->dest,
-          sni_properties[wrap->prop],wrap->sni->menu_path);
+      g_free(sni->menu_path);
+      g_variant_get(inner,"o",&(sni->menu_path));
+      g_debug("sni %s: property %s = %s",sni->dest,
+          sni_properties[prop],sni->menu_path);
     }
-  else if(wrap->prop == SNI_PROP_ISMENU)
+  else if(prop == SNI_PROP_ISMENU &&
+      g_variant_is_of_type(inner,G_VARIANT_TYPE_BOOLEAN))
   {
-    g_variant_get(inner,"b",&(wrap->sni->menu));
-    g_debug("sni %s: property %s = %d",wrap->sni->dest,
-        sni_properties[wrap->prop],wrap->sni->menu);
+    g_variant_get(inner,"b",&(sni->menu));
+    g_debug("sni %s: property %s = %d",sni->dest,
+        sni_properties[prop],sni->menu);
   }
-  else if(wrap->prop == SNI_PROP_ORDER)
+  else if(prop == SNI_PROP_ORDER &&
+      g_variant_is_of_type(inner,G_VARIANT_TYPE_UINT32))
+  {
+    g_variant_get(inner,"u",&(sni->order));
+    g_debug("sni %s: property %s = %u",sni->dest,
+        sni_properties[prop],sni->order);
+  }
+}
+
+static void sni_item_set_all ( SniItem *sni, GVariant *dict )
+{
+  GVariantIter iter;
+  GVariant *inner;
+  gchar *name;
+  guint i;
+
+  g_variant_iter_init(&iter, dict);
+  while(g_variant_iter_next(&iter, "{&sv}", &name, &inner))
   {
-    g_variant_get(inner,"u",&(wrap->sni->order));
-    g_debug("sni %s: property %s = %u",wrap->sni->dest,
-        sni_properties[wrap->prop],wrap->sni->order);
+    for(i=0; i<SNI_MAX_PROP; i++)
+      if(!g_strcmp0(name, sni_properties[i]))
+        sni_item_set_prop(sni, i, inner);
+    g_variant_unref(inner);
   }
+}
+
+static void sni_item_prop_cb ( GDBusConnection *con, GAsyncResult *res,
+    struct sni_prop_wrapper *wrap)
+{
+  GVariant *result, *inner;
+  GError *error = NULL;
+  sni_batch_t *batch = wrap->batch;
+  SniItem *sni = batch->sni;
+  guint prop = wrap->prop;
 
-  g_variant_unref(inner);
-  tray_invalidate_all(wrap->sni);
   g_free(wrap);
+  batch->count--;
+  result = g_dbus_connection_call_finish(con, res, &error);
+
+  /* the item is gone if the call was cancelled */
+  if(g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+  {
+    g_error_free(error);
+    if(!batch->count)
+      g_free(batch);
+    return;
+  }
+  sni->ref--;
+
+  if(!result && prop == SNI_PROP_ALL)
+  {
+    g_debug("sni %s: GetAll failed, falling back to Get", sni->dest);
+    sni_item_get_props(con, sni, (1<<SNI_MAX_PROP)-1);
+  }
+  else if(result && prop == SNI_PROP_ALL)
+  {
+    inner = g_variant_get_child_value(result, 0);
+    sni_item_set_all(sni, inner);
+    g_variant_unref(inner);
+    batch->changed = TRUE;
+  }
+  else if(result)
+  {
+    g_variant_get(result, "(v)",&inner);
+    sni_item_set_prop(sni, prop, inner);
+    g_variant_unref(inner);
+    batch->changed = TRUE;
+  }
+  g_clear_error(&error);
+  if(result)
+    g_variant_unref(result);
+
+  /* invalidate tray items once per batch of replies */
+  if(!batch->count)
+  {
+    if(batch->changed)
+      tray_invalidate_all(sni);
+    g_free(batch);
+  }
 }
 
-void sni_item_get_prop ( GDBusConnection *con, SniItem *sni,
+static void sni_item_call ( GDBusConnection *con, sni_batch_t *batch,
     guint prop )
 {
   struct sni_prop_wrapper *wrap;
 
   wrap = g_malloc(sizeof(struct sni_prop_wrapper));
   wrap->prop = prop;
-  wrap->sni = sni;
-  wrap->sni->ref++;
+  wrap->batch = batch;
+  batch->count++;
+  batch->sni->ref++;
 
-  g_dbus_connection_call(con, sni->dest, sni->path,
-    "org.freedesktop.DBus.Properties", "Get",
-    g_variant_new("(ss)", sni->host->item_iface, sni_properties[prop]),NULL,
-    G_DBUS_CALL_FLAGS_NONE,-1,sni->cancel,
-    (GAsyncReadyCallback)sni_item_prop_cb,wrap);
+  if(prop == SNI_PROP_ALL)
+    g_dbus_connection_call(con, batch->sni->dest, batch->sni->path,
+      "org.freedesktop.DBus.Properties", "GetAll",
+      g_variant_new("(s)", batch->sni->host->item_iface),
+      G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, -1,
+      batch->sni->cancel, (GAsyncReadyCallback)sni_item_prop_cb, wrap);
+  else
+    g_dbus_connection_call(con, batch->sni->dest, batch->sni->path,
+      "org.freedesktop.DBus.Properties", "Get",
+      g_variant_new("(ss)", batch->sni->host->item_iface,
+        sni_properties[prop]), NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+      batch->sni->cancel, (GAsyncReadyCallback)sni_item_prop_cb, wrap);
+}
+
+static sni_batch_t *sni_item_batch_new ( SniItem *sni )
+{
+  sni_batch_t *batch;
+
+  batch = g_malloc0(sizeof(sni_batch_t));
+  batch->sni = sni;
+
+  return batch;
+}
+
+static void sni_item_get_props ( GDBusConnection *con, SniItem *sni,
+    guint32 mask )
+{
+  sni_batch_t *batch;
+  guint i;
+
+  if(!mask)
+    return;
+
+  batch = sni_item_batch_new(sni);
+  for(i=0; i<SNI_MAX_PROP; i++)
+    if(mask & (1<<i))
+      sni_item_call(con, batch, i);
+}
+
+static gboolean sni_item_flush ( SniItem *sni )
+{
+  sni->timer = 0;
+  sni_item_get_props(sni_get_connection(), sni, sni->pending);
+  sni->pending = 0;
+
+  return FALSE;
+}
+
+/* property change signals often come in bursts, collect the properties
+ * to fetch over SNI_ITEM_DEBOUNCE ms and request each of them once */
+static void sni_item_queue ( SniItem *sni, guint32 mask )
+{
+  sni->pending |= mask;
+  if(!sni->timer)
+    sni->timer = g_timeout_add(SNI_ITEM_DEBOUNCE, (GSourceFunc)sni_item_flush,
+        sni);
 }
 
 void sni_item_signal_cb (GDBusConnection *con, const gchar *sender,
@@ -153,30 +349,21 @@ void sni_item_signal_cb (GDBusConnection *con, const gchar *sender,
 {
   g_debug("sni: received signal %s from %s",signal,sender);
   if(!g_strcmp0(signal,"NewTitle"))
-    sni_item_get_prop(con,data,SNI_PROP_TITLE);
+    sni_item_queue(data, 1<<SNI_PROP_TITLE);
   else if(!g_strcmp0(signal,"NewStatus"))
-    sni_item_get_prop(con,data,SNI_PROP_STATUS);
+    sni_item_queue(data, 1<<SNI_PROP_STATUS);
   else if(!g_strcmp0(signal,"NewToolTip"))
-    sni_item_get_prop(con,data,SNI_PROP_TOOLTIP);
+    sni_item_queue(data, 1<<SNI_PROP_TOOLTIP);
   else if(!g_strcmp0(signal,"NewIconThemePath"))
-    sni_item_get_prop(con,data,SNI_PROP_THEME);
+    sni_item_queue(data, 1<<SNI_PROP_THEME);
   else if(!g_strcmp0(signal,"NewIcon"))
-  {
-    sni_item_get_prop(con,data,SNI_PROP_ICON);
-    sni_item_get_prop(con,data,SNI_PROP_ICONPIX);
-  }
+    sni_item_queue(data, 1<<SNI_PROP_ICON | 1<<SNI_PROP_ICONPIX);
   else if(!g_strcmp0(signal,"NewOverlayIcon"))
-  {
-    sni_item_get_prop(con,data,SNI_PROP_OVLAY);
-    sni_item_get_prop(con,data,SNI_PROP_OVLAYPIX);
-  }
+    sni_item_queue(data, 1<<SNI_PROP_OVLAY | 1<<SNI_PROP_OVLAYPIX);
   else if(!g_strcmp0(signal,"NewAttentionIcon"))
-  {
-    sni_item_get_prop(con,data,SNI_PROP_ATTN);
-    sni_item_get_prop(con,data,SNI_PROP_ATTNPIX);
-  }
+    sni_item_queue(data, 1<<SNI_PROP_ATTN | 1<<SNI_PROP_ATTNPIX);
   else if(!g_strcmp0(signal,"XAyatanaNewLabel"))
-    sni_item_get_prop(con,data,SNI_PROP_LABEL);
+    sni_item_queue(data, 1<<SNI_PROP_LABEL);
 }
 
 SniItem *sni_item_new (GDBusConnection *con, SniHost *host,
@@ -184,7 +371,6 @@ SniItem *sni_item_new (GDBusConnection *con, SniHost *host,
 {
   SniItem *sni;
   gchar *path;
-  guint i;
 
   sni = g_malloc0(sizeof(SniItem));
   sni->uid = g_strdup(uid);
@@ -206,8 +392,7 @@ SniItem *sni_item_new (GDBusConnection *con, SniHost *host,
       sni->host->item_iface,NULL,sni->path,NULL,0,sni_item_signal_cb,sni,NULL);
   sni_items = g_list_append(sni_items, sni);
   tray_item_init_for_all(sni);
-  for(i=0;i<SNI_MAX_PROP;i++)
-    sni_item_get_prop(con,sni,i);
+  sni_item_call(con, sni_item_batch_new(sni), SNI_PROP_ALL);
 
   return sni;
 }
@@ -218,12 +403,18 @@ void sni_item_free ( SniItem *sni )
 
   tray_invalidate_all(sni);
   g_dbus_connection_signal_unsubscribe(sni_get_connection(),sni->signal);
+  if(sni->timer)
+    g_source_remove(sni->timer);
   tray_item_destroy(sni);
   g_cancellable_cancel(sni->cancel);
   g_object_unref(sni->cancel);
   for(i=0;i<3;i++)
+  {
     if(sni->pixbuf[i]!=NULL)
-      g_object_unref(sni->pixbuf[i]);
+      g_hash_table_destroy(sni->pixbuf[i]);
+    if(sni->pixmap[i]!=NULL)
+      g_variant_unref(sni->pixmap[i]);
+  }
   for(i=0;i<SNI_MAX_STRING;i++)
     g_free(sni->string[i]);
 
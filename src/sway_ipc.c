@@ -13,8 +13,14 @@
 #include "bar.h"
 #include "switcher.h"
 #include "wintree.h"
+#include "metrics.h"
+#include "trace.h"
 
 static gint main_ipc;
+static gint cmd_ipc = -1;
+static GString *cmd_queue;
+static guint cmd_flush_id;
+static guint cmd_watch_id;
 static const  gint8 magic[6] = {0x69, 0x33, 0x2d, 0x69, 0x70, 0x63};
 static ScanFile *sway_file;
 
@@ -67,6 +73,67 @@ static int sway_ipc_send ( gint sock, gint32 type, gchar *command )
   return 0;
 }
 
+/* remove the watch before closing, so it never polls a stale fd */
+static void sway_ipc_command_close ( void )
+{
+  if(cmd_watch_id)
+    g_source_remove(cmd_watch_id);
+  cmd_watch_id = 0;
+  if(cmd_ipc>=0)
+    close(cmd_ipc);
+  cmd_ipc = -1;
+}
+
+static gboolean sway_ipc_command_flush ( gpointer data )
+{
+  cmd_flush_id = 0;
+  if(!cmd_queue || !cmd_queue->len)
+    return FALSE;
+
+  g_debug("sway command: %s",cmd_queue->str);
+  if(sway_ipc_send(cmd_ipc, 0, cmd_queue->str)==-1)
+  {
+    g_debug("sway: command socket write failed, falling back to main socket");
+    sway_ipc_command_close();
+    sway_ipc_send(main_ipc, 0, cmd_queue->str);
+  }
+  g_string_truncate(cmd_queue, 0);
+
+  return FALSE;
+}
+
+static gboolean sway_ipc_command_reply ( GIOChannel *chan, GIOCondition cond,
+    gpointer data )
+{
+  struct json_object *obj, *item;
+  gint32 etype;
+  gint i;
+
+  if(cond & (G_IO_HUP | G_IO_ERR | G_IO_NVAL) ||
+      !(obj = sway_ipc_poll(cmd_ipc, &etype)) )
+  {
+    g_debug("sway: command socket closed");
+    cmd_watch_id = 0;
+    sway_ipc_command_close();
+    return FALSE;
+  }
+
+  if(json_object_is_type(obj, json_type_array))
+    for(i=0; i<json_object_array_length(obj); i++)
+    {
+      item = json_object_array_get_idx(obj, i);
+      if(!json_bool_by_name(item, "success", TRUE))
+        g_message("sway command failed: %s",
+            json_string_by_name(item, "error"));
+    }
+  json_object_put(obj);
+
+  return TRUE;
+}
+
+/* commands issued within one main loop iteration are batched into a single
+ * request on the command socket. Commands are joined with ';' rather than
+ * ',' so that criteria don't carry over from one command to the next */
 void sway_ipc_command ( gchar *cmd, ... )
 {
   va_list args;
@@ -77,22 +144,43 @@ void sway_ipc_command ( gchar *cmd, ... )
 
   va_start(args,cmd);
   buf = g_strdup_vprintf(cmd,args);
-  sway_ipc_send ( main_ipc, 0, buf);
-  g_free(buf);
   va_end(args);
+
+  if(cmd_ipc<0)
+  {
+    sway_ipc_send ( main_ipc, 0, buf);
+    g_free(buf);
+    return;
+  }
+
+  if(!cmd_queue)
+    cmd_queue = g_string_new(NULL);
+  if(cmd_queue->len)
+    g_string_append(cmd_queue, "; ");
+  g_string_append(cmd_queue, buf);
+  g_free(buf);
+
+  if(!cmd_flush_id)
+    cmd_flush_id = g_idle_add(sway_ipc_command_flush, NULL);
 }
 
 static json_object *sway_ipc_request ( gchar *command, gint32 type, gint32 *etype )
 {
   gint sock;
   json_object *json;
+  gint64 start, trace;
 
   sock = sway_ipc_open(3000);
   if(sock==-1)
     return NULL;
+  start = METRICS_NOW();
+  trace = TRACE_BEGIN();
   sway_ipc_send(sock,type,command);
   json = sway_ipc_poll(sock,etype);
   close(sock);
+  METRICS_INC(ipc_requests);
+  METRICS_TIME(ipc_request_time, ipc_request_max, start);
+  TRACE_END(trace, "ipc", "sway_ipc_request");
 
   return json;
 }
@@ -427,12 +515,15 @@ static gboolean sway_ipc_event ( GIOChannel *chan, GIOCondition cond,
 {
   struct json_object *obj;
   gint32 etype;
+  gint64 trace;
 
   if(main_ipc==-1)
     return FALSE;
 
   while ( (obj = sway_ipc_poll(main_ipc,&etype)) )
   { 
+    METRICS_INC(ipc_events);
+    trace = TRACE_BEGIN();
     if(etype==0x80000000)
       sway_ipc_workspace_event(obj);
     else if(etype==0x80000004)
@@ -457,6 +548,7 @@ static gboolean sway_ipc_event ( GIOChannel *chan, GIOCondition cond,
     sway_ipc_scan_input(obj, etype);
 
     json_object_put(obj);
+    TRACE_END(trace, "ipc", "sway_ipc_event");
   }
   return TRUE;
 }
@@ -621,4 +713,12 @@ void sway_ipc_init ( void )
       'bar_state_update','input']");
   GIOChannel *chan = g_io_channel_unix_new(main_ipc);
   g_io_add_watch(chan,G_IO_IN,sway_ipc_event,NULL);
+
+  cmd_ipc = sway_ipc_open(3000);
+  if(cmd_ipc<0)
+    return;
+  chan = g_io_channel_unix_new(cmd_ipc);
+  cmd_watch_id = g_io_add_watch(chan, G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+      sway_ipc_command_reply, NULL);
+  g_io_channel_unref(chan);
 }
@@ -21,7 +21,7 @@ static GtkWidget *switcher_win;
 static GtkWidget *grid;
 static gint interval;
 static gchar hstate;
-static gint counter;
+static guint timer;
 static gint title_width = -1;
 static window_t *focus;
 
@@ -60,6 +60,26 @@ GtkWidget *switcher_new ( void )
   return grid;
 }
 
+/* drop the switcher ahead of a config reload, the reloaded config creates
+ * it again if it still has a switcher block */
+void switcher_destroy ( void )
+{
+  if(!grid)
+    return;
+
+  if(timer)
+  {
+    g_source_remove(timer);
+    timer = 0;
+  }
+  gtk_widget_destroy(switcher_win);
+  switcher_win = NULL;
+  grid = NULL;
+  focus = NULL;
+  interval = 0;
+  title_width = -1;
+}
+
 void switcher_populate ( void )
 {
   GList *iter;
@@ -98,6 +118,16 @@ gboolean switcher_check ( GtkWidget *switcher, window_t *win )
   return !wintree_is_filtered(win);
 }
 
+static gboolean switcher_hide ( gpointer data )
+{
+  timer = 0;
+  gtk_widget_hide(switcher_win);
+  if(focus)
+    wintree_focus(focus->uid);
+
+  return FALSE;
+}
+
 gboolean switcher_event ( gpointer dir )
 {
   GList *iter, *list = NULL, *flink = NULL;
@@ -105,9 +135,8 @@ gboolean switcher_event ( gpointer dir )
   if(!grid)
     return TRUE;
 
-  if(counter<1 || !focus)
+  if(!timer || !focus)
     focus = wintree_from_id(wintree_get_focus());
-  counter = interval + 1;
 
   for (iter = wintree_get_list(); iter; iter = g_list_next(iter) )
     if(switcher_check(grid, iter->data))
@@ -125,11 +154,22 @@ gboolean switcher_event ( gpointer dir )
 
   g_list_free(list);
 
+  for(iter=wintree_get_list(); iter; iter=g_list_next(iter))
+    flow_item_invalidate(flow_grid_find_child(grid, iter->data));
+  flow_grid_update(grid);
+  css_widget_cascade(switcher_win, NULL);
+
+  if(timer)
+    g_source_remove(timer);
+  timer = g_timeout_add(MAX(interval, 1)*100, switcher_hide, NULL);
+
   return TRUE;
 }
 
 void switcher_window_delete (window_t *win )
 {
+  if(focus == win)
+    focus = NULL;
   if(grid)
     flow_grid_delete_child(grid, win);
 }
@@ -140,32 +180,6 @@ void switcher_window_init (window_t *win )
     flow_grid_add_child(grid, switcher_item_new(win, grid));
 }
 
-
-void switcher_update ( void )
-{
-  GList *iter;
-
-  if(!grid)
-    return;
-
-  if(counter <= 0)
-    return;
-  counter--;
-
-  if(counter > 0)
-  {
-    for(iter=wintree_get_list(); iter; iter=g_list_next(iter))
-      flow_item_invalidate(flow_grid_find_child(grid, iter->data));
-    flow_grid_update(grid);
-    css_widget_cascade(switcher_win, NULL);
-  }
-  else
-  {
-    gtk_widget_hide(switcher_win);
-    wintree_focus(focus->uid);
-  }
-}
-
 void switcher_set_filter ( GtkWidget *self, gint filter )
 {
   SwitcherPrivate *priv;
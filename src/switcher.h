@@ -38,9 +38,9 @@ GtkWidget *switcher_new();
 gboolean switcher_state ( void );
 gboolean switcher_event ( gpointer );
 void switcher_invalidate ( window_t *win );
-void switcher_update ( void );
 void switcher_window_init ( window_t *win);
 void switcher_populate ( void );
+void switcher_destroy ( void );
 void switcher_set_filter ( GtkWidget *self, gint filter );
 gint switcher_get_filter ( GtkWidget *self );
 gboolean switcher_check ( GtkWidget *switcher, window_t *win );
@@ -16,6 +16,7 @@ G_DEFINE_TYPE_WITH_CODE (Taskbar, taskbar, FLOW_GRID_TYPE,
     G_ADD_PRIVATE (Taskbar))
 
 static GList *taskbars;
+static GHashTable *win_items;
 
 static GtkWidget *taskbar_mirror ( GtkWidget *src )
 {
@@ -177,20 +178,44 @@ gint taskbar_get_filter ( GtkWidget *self, gboolean *floating )
   return priv->filter;
 }
 
+/* keep a list of taskbar items for each window, so we can reach all items
+ * representing a window without scanning all taskbars */
+void taskbar_window_item_add ( window_t *win, GtkWidget *item )
+{
+  GList *list;
+
+  if(!win_items)
+    win_items = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+        (GDestroyNotify)g_list_free);
+
+  list = g_hash_table_lookup(win_items, win);
+  g_hash_table_steal(win_items, win);
+  g_hash_table_insert(win_items, win, g_list_prepend(list, item));
+}
+
+void taskbar_window_item_remove ( window_t *win, GtkWidget *item )
+{
+  GList *list;
+
+  if(!win_items || !g_hash_table_contains(win_items, win))
+    return;
+
+  list = g_hash_table_lookup(win_items, win);
+  g_hash_table_steal(win_items, win);
+  list = g_list_remove(list, item);
+  if(list)
+    g_hash_table_insert(win_items, win, list);
+}
+
 void taskbar_invalidate_item ( window_t *win )
 {
   GList *iter;
-  GtkWidget *taskbar;
 
-  for(iter=taskbars; iter; iter=g_list_next(iter))
-  {
-    taskbar = taskbar_holder_get(iter->data, win, FALSE);
-    if(taskbar)
-      flow_item_invalidate(flow_grid_find_child(taskbar, win));
-    if(taskbar!=iter->data)
-      flow_item_invalidate(
-          flow_grid_find_child(iter->data, taskbar_group_id(iter->data, win)));
-  }
+  if(!win_items)
+    return;
+
+  for(iter=g_hash_table_lookup(win_items, win); iter; iter=g_list_next(iter))
+    flow_item_invalidate(iter->data);
 }
 
 void taskbar_invalidate_all ( void )
@@ -222,6 +247,8 @@ void taskbar_destroy_item ( window_t *win )
         flow_grid_delete_child(iter->data, taskbar_group_id(iter->data, win));
       taskbar_invalidate_item(win);
     }
+  if(win_items)
+    g_hash_table_remove(win_items, win);
 }
 
 void taskbar_populate ( void )
@@ -231,8 +258,3 @@ void taskbar_populate ( void )
   for(iter=wintree_get_list(); iter; iter=g_list_next(iter))
     taskbar_init_item (iter->data);
 }
-
-void taskbar_update_all ( void )
-{
-  g_list_foreach(taskbars, (GFunc)flow_grid_update, NULL);
-}
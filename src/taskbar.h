@@ -41,7 +41,6 @@ GType taskbar_get_type ( void );
 
 GtkWidget *taskbar_new( gboolean );
 void taskbar_populate ( void );
-void taskbar_update_all ( void );
 void taskbar_init_item ( window_t *win );
 void taskbar_destroy_item ( window_t *win );
 void taskbar_set_filter ( GtkWidget *self, gint filter );
@@ -49,6 +48,8 @@ gint taskbar_get_filter ( GtkWidget *self, gboolean * );
 void taskbar_invalidate_all ( void );
 gpointer taskbar_group_id ( GtkWidget *self, window_t *win );
 void taskbar_invalidate_item ( window_t *win );
+void taskbar_window_item_add ( window_t *win, GtkWidget *item );
+void taskbar_window_item_remove ( window_t *win, GtkWidget *item );
 void taskbar_set_grouping ( GtkWidget *self, gint grouping );
 
 #endif
@@ -125,7 +125,7 @@ static void taskbar_item_update ( GtkWidget *self )
     if(priv->win->appid && *(priv->win->appid))
       appid = priv->win->appid;
     else
-      appid = wintree_appid_map_lookup(priv->win->title);
+      appid = wintree_appid_map_lookup(priv->win);
     taskbar_item_set_image(priv->icon, appid);
   }
 
@@ -167,8 +167,20 @@ static void taskbar_item_invalidate ( GtkWidget *self )
         flow_grid_find_child(parent, taskbar_group_id(parent, priv->win)));
 }
 
+static void taskbar_item_destroy ( GtkWidget *self )
+{
+  TaskbarItemPrivate *priv;
+
+  g_return_if_fail(IS_TASKBAR_ITEM(self));
+  priv = taskbar_item_get_instance_private(TASKBAR_ITEM(self));
+
+  taskbar_window_item_remove(priv->win, self);
+  GTK_WIDGET_CLASS(taskbar_item_parent_class)->destroy(self);
+}
+
 static void taskbar_item_class_init ( TaskbarItemClass *kclass )
 {
+  GTK_WIDGET_CLASS(kclass)->destroy = taskbar_item_destroy;
   BASE_WIDGET_CLASS(kclass)->action_exec = taskbar_item_action_exec;
   FLOW_ITEM_CLASS(kclass)->update = taskbar_item_update;
   FLOW_ITEM_CLASS(kclass)->invalidate = taskbar_item_invalidate;
@@ -241,6 +253,7 @@ GtkWidget *taskbar_item_new( window_t *win, GtkWidget *taskbar )
   priv->actions = g_object_get_data(G_OBJECT(taskbar), "actions");
   g_object_ref_sink(G_OBJECT(self));
   flow_grid_add_child(taskbar, self);
+  taskbar_window_item_add(win, self);
 
   gtk_widget_add_events(self, GDK_BUTTON_RELEASE_MASK | GDK_SCROLL_MASK);
   taskbar_item_invalidate(self);
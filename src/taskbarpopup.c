@@ -211,6 +211,8 @@ static void taskbar_popup_class_init ( TaskbarPopupClass *kclass )
   FLOW_ITEM_CLASS(kclass)->update = taskbar_popup_update;
   FLOW_ITEM_CLASS(kclass)->invalidate = taskbar_popup_invalidate;
   FLOW_ITEM_CLASS(kclass)->comp_source = (GCompareFunc)g_strcmp0;
+  FLOW_ITEM_CLASS(kclass)->hash_source = g_str_hash;
+  FLOW_ITEM_CLASS(kclass)->equal_source = g_str_equal;
   FLOW_ITEM_CLASS(kclass)->compare = taskbar_popup_compare;
   FLOW_ITEM_CLASS(kclass)->get_source =
     (void * (*)(GtkWidget *))taskbar_popup_get_appid;
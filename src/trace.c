@@ -0,0 +1,344 @@
+/* This entire file is licensed under GNU General Public License v3.0
+ *
+ * Copyright 2024- sfwbar maintainers
+ */
+
+#include <gtk/gtk.h>
+#include <json.h>
+#include <string.h>
+#include <unistd.h>
+#include "trace.h"
+#include "meson.h"
+
+/* startup timeline. Phases, config files and modules are recorded on the
+ * main thread until the first frame of a bar is drawn. The timeline is
+ * then printed sorted by duration or written as a chrome trace json */
+typedef struct trace_span {
+  const gchar *cat;
+  gchar *name;
+  gint64 start, dur;
+} trace_span_t;
+
+static gchar *startup_dest;
+static gint64 startup_t0;
+static GArray *startup_spans;
+
+void trace_startup_init ( gchar *dest )
+{
+  if(!dest)
+    return;
+
+  startup_dest = g_strdup(dest);
+  startup_t0 = g_get_monotonic_time();
+  startup_spans = g_array_new(FALSE, FALSE, sizeof(trace_span_t));
+}
+
+gint64 trace_startup_origin ( void )
+{
+  return startup_spans? startup_t0 : 0;
+}
+
+gint64 trace_startup_begin ( void )
+{
+  return startup_spans? g_get_monotonic_time() : 0;
+}
+
+/* returns the end time, so consecutive phases can be chained */
+gint64 trace_startup_end ( gint64 start, const gchar *cat, const gchar *name )
+{
+  trace_span_t span;
+  gint64 now;
+
+  if(!startup_spans || !start)
+    return 0;
+
+  now = g_get_monotonic_time();
+  span.cat = cat;
+  span.name = g_strdup(name);
+  span.start = start;
+  span.dur = now - start;
+  g_array_append_val(startup_spans, span);
+
+  return now;
+}
+
+static json_object *trace_json_event ( const gchar *cat, const gchar *name,
+    gchar ph, gint64 ts, gint64 dur, gint64 tid )
+{
+  json_object *event;
+  gchar phase[2] = { ph, 0 };
+
+  event = json_object_new_object();
+  json_object_object_add(event, "name", json_object_new_string(name));
+  json_object_object_add(event, "cat", json_object_new_string(cat));
+  json_object_object_add(event, "ph", json_object_new_string(phase));
+  json_object_object_add(event, "ts", json_object_new_int64(ts));
+  if(ph == 'X')
+    json_object_object_add(event, "dur", json_object_new_int64(dur));
+  else if(ph == 'i')
+    json_object_object_add(event, "s", json_object_new_string("g"));
+  json_object_object_add(event, "pid", json_object_new_int64(getpid()));
+  json_object_object_add(event, "tid", json_object_new_int64(tid));
+
+  return event;
+}
+
+static gboolean trace_json_write ( const gchar *fname, json_object *events )
+{
+  json_object *trace;
+  const gchar *json;
+  GError *error = NULL;
+  gboolean result;
+
+  trace = json_object_new_object();
+  json_object_object_add(trace, "traceEvents", events);
+  json_object_object_add(trace, "displayTimeUnit",
+      json_object_new_string("ms"));
+  json = json_object_to_json_string_ext(trace, JSON_C_TO_STRING_PLAIN);
+
+  if( !(result = g_file_set_contents(fname, json, -1, &error)) )
+  {
+    g_message("trace: unable to write %s: %s", fname, error->message);
+    g_error_free(error);
+  }
+  json_object_put(trace);
+
+  return result;
+}
+
+static gint trace_span_comp ( trace_span_t *s1, trace_span_t *s2 )
+{
+  return s1->dur < s2->dur? 1 : (s1->dur > s2->dur? -1 : 0);
+}
+
+gboolean trace_startup_done ( gpointer d )
+{
+  json_object *events;
+  trace_span_t *span;
+  gint64 total;
+  guint i;
+
+  if(!startup_spans)
+    return FALSE;
+
+  total = g_get_monotonic_time() - startup_t0;
+
+  if(!g_strcmp0(startup_dest, "-"))
+  {
+    g_array_sort(startup_spans, (GCompareFunc)trace_span_comp);
+    g_message("startup: first frame after %.1fms", total/1000.0);
+    for(i=0; i<startup_spans->len; i++)
+    {
+      span = &g_array_index(startup_spans, trace_span_t, i);
+      g_message("startup: %8.1fms %5.1f%% %-7s %s", span->dur/1000.0,
+          100.0*span->dur/MAX(total, 1), span->cat, span->name);
+    }
+  }
+  else
+  {
+    events = json_object_new_array();
+    for(i=0; i<startup_spans->len; i++)
+    {
+      span = &g_array_index(startup_spans, trace_span_t, i);
+      json_object_array_add(events, trace_json_event(span->cat, span->name,
+            'X', span->start - startup_t0, span->dur, 1));
+    }
+    json_object_array_add(events, trace_json_event("startup", "first frame",
+          'i', total, 0, 1));
+    trace_json_write(startup_dest, events);
+  }
+
+  for(i=0; i<startup_spans->len; i++)
+    g_free(g_array_index(startup_spans, trace_span_t, i).name);
+  g_clear_pointer(&startup_spans, g_array_unref);
+  g_clear_pointer(&startup_dest, g_free);
+
+  return FALSE;
+}
+
+static gboolean trace_startup_draw_cb ( GtkWidget *widget, cairo_t *cr,
+    gpointer d )
+{
+  g_signal_handlers_disconnect_by_func(widget,
+      (gpointer)trace_startup_draw_cb, d);
+  trace_startup_done(NULL);
+
+  return FALSE;
+}
+
+/* finish the startup timeline once the widget draws its first frame */
+void trace_startup_watch ( GtkWidget *widget )
+{
+  if(startup_spans)
+    g_signal_connect_after(G_OBJECT(widget), "draw",
+        G_CALLBACK(trace_startup_draw_cb), NULL);
+}
+
+#if METRICS
+
+/* runtime spans. Each thread records into its own ring, so the hot path
+ * takes no locks: the owner advances the head after filling a slot. The
+ * dump copies a ring, re-reads the head and discards the slots the owner
+ * may have rewritten during the copy (seqlock style), so a dump never
+ * contains torn spans */
+#define TRACE_RING_SIZE 4096
+G_STATIC_ASSERT((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0);
+
+typedef struct trace_ring {
+  const gchar *thread;
+  gint64 tid;
+  guint head;
+  gboolean full;
+  trace_span_t spans[TRACE_RING_SIZE];
+} trace_ring_t;
+
+static void trace_ring_free ( trace_ring_t *ring );
+
+/* rings of exited threads (i.e. pool workers) are freed with the thread */
+static GPrivate trace_ring_key = G_PRIVATE_INIT(
+    (GDestroyNotify)trace_ring_free);
+static GPrivate trace_thread_key;
+static GMutex trace_rings_mutex;
+static GList *trace_rings;
+static gint trace_active;
+static gint64 trace_t0;
+static gint trace_tid;
+
+/* label the calling thread in runtime traces */
+void trace_thread_name ( const gchar *name )
+{
+  g_private_set(&trace_thread_key, (gpointer)name);
+}
+
+static void trace_ring_free ( trace_ring_t *ring )
+{
+  g_mutex_lock(&trace_rings_mutex);
+  trace_rings = g_list_remove(trace_rings, ring);
+  g_mutex_unlock(&trace_rings_mutex);
+  g_free(ring);
+}
+
+static trace_ring_t *trace_ring_get ( void )
+{
+  trace_ring_t *ring;
+
+  if( (ring = g_private_get(&trace_ring_key)) )
+    return ring;
+
+  ring = g_malloc0(sizeof(trace_ring_t));
+  ring->tid = g_atomic_int_add(&trace_tid, 1) + 1;
+  if( !(ring->thread = g_private_get(&trace_thread_key)) )
+    ring->thread = g_main_context_is_owner(g_main_context_default())?
+      "gtk" : "worker";
+  g_private_set(&trace_ring_key, ring);
+
+  g_mutex_lock(&trace_rings_mutex);
+  trace_rings = g_list_append(trace_rings, ring);
+  g_mutex_unlock(&trace_rings_mutex);
+
+  return ring;
+}
+
+gint64 trace_span_begin ( void )
+{
+  return g_atomic_int_get(&trace_active)? g_get_monotonic_time() : 0;
+}
+
+/* record a span timed by the caller. cat and name must be static strings,
+ * they are read at dump time */
+void trace_span_record ( gint64 start, gint64 end, const gchar *cat,
+    const gchar *name )
+{
+  trace_ring_t *ring;
+  trace_span_t *span;
+  guint head;
+
+  if(!start || !g_atomic_int_get(&trace_active))
+    return;
+
+  ring = trace_ring_get();
+  head = ring->head;
+  span = &ring->spans[head & (TRACE_RING_SIZE - 1)];
+  span->cat = cat;
+  span->name = (gchar *)name;
+  span->start = start;
+  span->dur = end - start;
+  if(head + 1 >= TRACE_RING_SIZE)
+    ring->full = TRUE;
+  g_atomic_int_set(&ring->head, head + 1);
+}
+
+void trace_span_end ( gint64 start, const gchar *cat, const gchar *name )
+{
+  if(start)
+    trace_span_record(start, g_get_monotonic_time(), cat, name);
+}
+
+void trace_start ( void )
+{
+  trace_t0 = g_get_monotonic_time();
+  g_atomic_int_set(&trace_active, TRUE);
+}
+
+static json_object *trace_json_thread ( trace_ring_t *ring )
+{
+  json_object *event, *args;
+
+  args = json_object_new_object();
+  json_object_object_add(args, "name", json_object_new_string(ring->thread));
+  event = json_object_new_object();
+  json_object_object_add(event, "name", json_object_new_string("thread_name"));
+  json_object_object_add(event, "ph", json_object_new_string("M"));
+  json_object_object_add(event, "pid", json_object_new_int64(getpid()));
+  json_object_object_add(event, "tid", json_object_new_int64(ring->tid));
+  json_object_object_add(event, "args", args);
+
+  return event;
+}
+
+/* write the spans recorded since trace_start, recording continues */
+void trace_dump ( const gchar *fname )
+{
+  json_object *events;
+  trace_ring_t *ring;
+  trace_span_t *copy, *span;
+  GList *iter;
+  guint head, head2, i;
+
+  if(!g_atomic_int_get(&trace_active))
+  {
+    g_message("trace: recording isn't active");
+    return;
+  }
+
+  events = json_object_new_array();
+  copy = g_malloc(sizeof(trace_span_t) * TRACE_RING_SIZE);
+  g_mutex_lock(&trace_rings_mutex);
+  for(iter=trace_rings; iter; iter=g_list_next(iter))
+  {
+    ring = iter->data;
+    json_object_array_add(events, trace_json_thread(ring));
+    head = g_atomic_int_get(&ring->head);
+    memcpy(copy, ring->spans, sizeof(trace_span_t) * TRACE_RING_SIZE);
+    head2 = g_atomic_int_get(&ring->head);
+    /* the head is free running and may wrap, unsigned arithmetic keeps
+     * the index sequence intact across the wrap. Slots at or beyond a ring
+     * length behind head2 were (or are being) rewritten during the copy */
+    for(i = head - (ring->full? TRACE_RING_SIZE : head); i != head; i++)
+    {
+      if(head2 - i >= TRACE_RING_SIZE)
+        continue;
+      span = &copy[i & (TRACE_RING_SIZE - 1)];
+      if(span->start >= trace_t0)
+        json_object_array_add(events, trace_json_event(span->cat, span->name,
+              'X', span->start - trace_t0, span->dur, ring->tid));
+    }
+  }
+  g_mutex_unlock(&trace_rings_mutex);
+  g_free(copy);
+
+  if(trace_json_write(fname, events))
+    g_message("trace: written to %s", fname);
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <gtk/gtk.h>
+#include "meson.h"
+
+void trace_startup_init ( gchar *dest );
+gint64 trace_startup_origin ( void );
+gint64 trace_startup_begin ( void );
+gint64 trace_startup_end ( gint64 start, const gchar *cat, const gchar *name );
+gboolean trace_startup_done ( gpointer d );
+void trace_startup_watch ( GtkWidget *widget );
+
+/* runtime spans compile out when built with -Dmetrics=disabled */
+#if METRICS
+#define TRACE_BEGIN() trace_span_begin()
+#define TRACE_END(start, cat, name) trace_span_end(start, cat, name)
+#define TRACE_SPAN(start, end, cat, name) \
+  trace_span_record(start, end, cat, name)
+
+gint64 trace_span_begin ( void );
+void trace_span_end ( gint64 start, const gchar *cat, const gchar *name );
+void trace_span_record ( gint64 start, gint64 end, const gchar *cat,
+    const gchar *name );
+void trace_thread_name ( const gchar *name );
+void trace_start ( void );
+void trace_dump ( const gchar *fname );
+#else
+#define TRACE_BEGIN() 0
+#define TRACE_END(start, cat, name) ((void)(start))
+#define TRACE_SPAN(start, end, cat, name) ((void)(start), (void)(end))
+#define trace_thread_name(name) ((void)(name))
+#endif
+
+#endif
@@ -76,11 +76,3 @@ void tray_item_destroy ( SniItem *sni )
 {
   g_list_foreach(trays, (GFunc)flow_grid_delete_child, sni);
 }
-
-void tray_update ( void )
-{
-  GList *iter;
-
-  for(iter=trays; iter; iter=g_list_next(iter))
-    flow_grid_update(iter->data);
-}
@@ -15,6 +15,7 @@ G_DEFINE_TYPE_WITH_CODE (TrayItem, tray_item, FLOW_ITEM_TYPE,
 void tray_item_update ( GtkWidget *self )
 {
   TrayItemPrivate *priv;
+  GdkPixbuf *buf;
   gint icon=-1, pix=-1;
 
   g_return_if_fail(IS_TRAY_ITEM(self));
@@ -50,9 +51,9 @@ void tray_item_update ( GtkWidget *self )
   else if(priv->sni->string[icon] && *(priv->sni->string[icon]))
     scale_image_set_image(priv->icon, priv->sni->string[icon],
         priv->sni->string[SNI_PROP_THEME]);
-  else if(priv->sni->pixbuf[pix-SNI_PROP_ICONPIX])
-    scale_image_set_pixbuf(priv->icon,
-        priv->sni->pixbuf[pix-SNI_PROP_ICONPIX]);
+  else if( (buf = sni_item_get_pixbuf(priv->sni, pix-SNI_PROP_ICONPIX,
+          priv->icon_size)) )
+    scale_image_set_pixbuf(priv->icon, buf);
 
   if(priv->sni->string[SNI_PROP_LABEL] &&
       *(priv->sni->string[SNI_PROP_LABEL]))
@@ -197,6 +198,24 @@ static void tray_item_invalidate ( GtkWidget *self )
   priv->invalid = TRUE;
 }
 
+/* re-select the icon pixmap if the rendered icon size changes */
+static void tray_item_icon_allocate ( GtkWidget *icon, GtkAllocation *alloc,
+    GtkWidget *self )
+{
+  TrayItemPrivate *priv;
+  gint size;
+
+  g_return_if_fail(IS_TRAY_ITEM(self));
+  priv = tray_item_get_instance_private(TRAY_ITEM(self));
+
+  size = MAX(alloc->width, alloc->height) * gtk_widget_get_scale_factor(icon);
+  if(size == priv->icon_size)
+    return;
+
+  priv->icon_size = size;
+  flow_item_invalidate(self);
+}
+
 static void tray_item_class_init ( TrayItemClass *kclass )
 {
   BASE_WIDGET_CLASS(kclass)->action_exec = tray_item_action_exec;
@@ -231,6 +250,9 @@ GtkWidget *tray_item_new( SniItem *sni, GtkWidget *tray )
   flow_grid_child_dnd_enable(tray, self, priv->button);
 
   priv->icon = scale_image_new();
+  priv->icon_size = 16;
+  g_signal_connect(G_OBJECT(priv->icon), "size-allocate",
+      G_CALLBACK(tray_item_icon_allocate), self);
   priv->label = gtk_label_new("");
   priv->sni = sni;
   priv->tray = tray;
@@ -33,6 +33,7 @@ struct _TrayItemPrivate
   GtkWidget *icon;
   GtkWidget *label;
   GtkWidget *tray;
+  gint icon_size;
   gboolean invalid;
 };
 
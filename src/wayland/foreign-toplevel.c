@@ -24,65 +24,166 @@ void foreign_toplevel_activate ( gpointer tl )
         gdk_display_get_default_seat(gdk_display_get_default())));
 }
 
+/* foreign toplevel events are accumulated in a per-toplevel pending state
+ * and applied to the wintree in one go on the done event. Commits are also
+ * limited to one per frame interval, so toplevels that update their title
+ * continuously don't keep invalidating the taskbar and the switcher */
+#define TOPLEVEL_COMMIT_INTERVAL 16
+
+typedef struct toplevel_pending {
+  wlr_fth *tl;
+  gchar *title;
+  gchar *appid;
+  GList *outputs;
+  guint16 state;
+  gboolean state_changed;
+  gboolean outputs_changed;
+  gboolean ready;
+  guint timer;
+} toplevel_pending_t;
+
+static void toplevel_pending_apply ( toplevel_pending_t *pending )
+{
+  window_t *win;
+
+  pending->ready = FALSE;
+  win = wintree_from_id(pending->tl);
+  if(!win)
+    return;
+
+  if(pending->appid)
+    wintree_update_app_id(win, pending->appid);
+  if(pending->title)
+    wintree_update_title(win, pending->title);
+  g_clear_pointer(&pending->appid, g_free);
+  g_clear_pointer(&pending->title, g_free);
+
+  if(pending->outputs_changed)
+  {
+    g_list_free_full(win->outputs, g_free);
+    win->outputs = pending->outputs;
+    pending->outputs = NULL;
+    pending->outputs_changed = FALSE;
+  }
+
+  if(pending->state_changed)
+  {
+    win->state = pending->state;
+    pending->state_changed = FALSE;
+    if(win->state & WS_FOCUSED)
+      wintree_set_focus(win->uid);
+    else if(wintree_is_focused(win->uid))
+      wintree_set_focus(NULL);
+    g_debug("foreign toplevel state for %p: %s%s%s%s", win->uid,
+      win->state & WS_FOCUSED ? "Activated, " : "",
+      win->state & WS_MINIMIZED ? "Minimized, " : "",
+      win->state & WS_MAXIMIZED ? "Maximized, " : "",
+      win->state & WS_FULLSCREEN ? "Fullscreen" : ""
+      );
+  }
+
+  wintree_log(win->uid);
+  wintree_commit(win);
+}
+
+static gboolean toplevel_pending_timer ( toplevel_pending_t *pending )
+{
+  if(pending->ready)
+  {
+    toplevel_pending_apply(pending);
+    return TRUE;
+  }
+  pending->timer = 0;
+  return FALSE;
+}
+
+static void toplevel_pending_free ( toplevel_pending_t *pending )
+{
+  if(pending->timer)
+    g_source_remove(pending->timer);
+  g_free(pending->title);
+  g_free(pending->appid);
+  g_list_free_full(pending->outputs, g_free);
+  g_free(pending);
+}
+
+static GList **toplevel_pending_outputs ( toplevel_pending_t *pending )
+{
+  window_t *win;
+  GList *iter;
+
+  if(!pending->outputs_changed)
+  {
+    pending->outputs_changed = TRUE;
+    if( (win = wintree_from_id(pending->tl)) )
+      for(iter=win->outputs; iter; iter=g_list_next(iter))
+        pending->outputs = g_list_append(pending->outputs,
+            g_strdup(iter->data));
+  }
+  return &pending->outputs;
+}
+
 static void toplevel_handle_app_id(void *data, wlr_fth *tl, const gchar *appid)
 {
-  wintree_set_app_id(tl,appid);
+  toplevel_pending_t *pending = data;
+
+  g_free(pending->appid);
+  pending->appid = g_strdup(appid);
 }
 
 static void toplevel_handle_title(void *data, wlr_fth *tl, const gchar *title)
 {
-  wintree_set_title(tl,title);
+  toplevel_pending_t *pending = data;
+
+  g_free(pending->title);
+  pending->title = g_strdup(title);
 }
 
 static void toplevel_handle_closed(void *data, wlr_fth *tl)
 {
+  toplevel_pending_free(data);
   wintree_window_delete(tl);
   zwlr_foreign_toplevel_handle_v1_destroy(tl);
 }
 
 static void toplevel_handle_done(void *data, wlr_fth *tl)
 {
-  wintree_log(tl);
+  toplevel_pending_t *pending = data;
+
+  pending->ready = TRUE;
+  if(pending->timer)
+    return;
+
+  toplevel_pending_apply(pending);
+  pending->timer = g_timeout_add(TOPLEVEL_COMMIT_INTERVAL,
+      (GSourceFunc)toplevel_pending_timer, pending);
 }
 
 static void toplevel_handle_state(void *data, wlr_fth *tl,
                 struct wl_array *state)
 {
+  toplevel_pending_t *pending = data;
   uint32_t *entry;
-  window_t *win;
 
-  win = wintree_from_id(tl);
-  if(!win)
-    return;
-
-  win->state = 0;
+  pending->state = 0;
+  pending->state_changed = TRUE;
 
   wl_array_for_each(entry, state)
     switch(*entry)
     {
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MINIMIZED:
-      win->state |= WS_MINIMIZED;
+      pending->state |= WS_MINIMIZED;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MAXIMIZED:
-      win->state |= WS_MAXIMIZED;
+      pending->state |= WS_MAXIMIZED;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_FULLSCREEN:
-      win->state |= WS_FULLSCREEN;
+      pending->state |= WS_FULLSCREEN;
       break;
     case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_ACTIVATED:
-      win->state |= WS_FOCUSED;
-      wintree_set_focus(win->uid);
+      pending->state |= WS_FOCUSED;
       break;
     }
-
-  if(wintree_is_focused(win->uid) && !(win->state & WS_FOCUSED))
-    wintree_set_focus(NULL);
-  g_debug("foreign toplevel state for %p: %s%s%s%s", win->uid,
-    win->state & WS_FOCUSED ? "Activated, " : "",
-    win->state & WS_MINIMIZED ? "Minimized, " : "",
-    win->state & WS_MAXIMIZED ? "Maximized, " : "",
-    win->state & WS_FULLSCREEN ? "Fullscreen" : ""
-    );
 }
 
 static void toplevel_handle_parent(void *data, wlr_fth *tl, wlr_fth *pt)
@@ -108,39 +209,32 @@ static void toplevel_handle_output_leave(void *data, wlr_fth *tl,
     struct wl_output *output)
 {
   char *name;
-  window_t *win;
-  GList *link;
+  GList **outputs, *link;
 
   name = toplevel_output_name_get(output);
   if(!name)
     return;
-  win = wintree_from_id(tl);
-  if(!win)
-    return;
-  link = g_list_find_custom(win->outputs,name,(GCompareFunc)g_strcmp0);
+  outputs = toplevel_pending_outputs(data);
+  link = g_list_find_custom(*outputs,name,(GCompareFunc)g_strcmp0);
   if(!link)
     return;
   g_free(link->data);
-  win->outputs = g_list_delete_link(win->outputs,link);
-  wintree_commit(win);
+  *outputs = g_list_delete_link(*outputs,link);
 }
 
 static void toplevel_handle_output_enter(void *data, wlr_fth *tl,
     struct wl_output *output)
 {
   char *name;
-  window_t *win;
+  GList **outputs;
 
   name = toplevel_output_name_get(output);
   if(!name)
     return;
-  win = wintree_from_id(tl);
-  if(!win)
-    return;
-  if(g_list_find_custom(win->outputs,name,(GCompareFunc)g_strcmp0))
+  outputs = toplevel_pending_outputs(data);
+  if(g_list_find_custom(*outputs,name,(GCompareFunc)g_strcmp0))
     return;
-  win->outputs = g_list_prepend(win->outputs,g_strdup(name));
-  wintree_commit(win);
+  *outputs = g_list_prepend(*outputs,g_strdup(name));
 }
 
 static const struct zwlr_foreign_toplevel_handle_v1_listener toplevel_impl = {
@@ -157,13 +251,16 @@ static const struct zwlr_foreign_toplevel_handle_v1_listener toplevel_impl = {
 static void toplevel_manager_handle_toplevel(void *data,
   struct zwlr_foreign_toplevel_manager_v1 *toplevel_manager, wlr_fth *tl)
 {
+  toplevel_pending_t *pending;
   window_t *win;
 
   win = wintree_window_init();
   win->uid = tl;
   wintree_window_append(win);
 
-  zwlr_foreign_toplevel_handle_v1_add_listener(tl, &toplevel_impl, NULL);
+  pending = g_malloc0(sizeof(toplevel_pending_t));
+  pending->tl = tl;
+  zwlr_foreign_toplevel_handle_v1_add_listener(tl, &toplevel_impl, pending);
 }
 
 static void toplevel_manager_handle_finished(void *data,
@@ -9,9 +9,16 @@
 
 static struct wintree_api api;
 static GList *wt_list;
+static GList *wt_tail;
+static GHashTable *wt_uid_index;
+static GHashTable *wt_pid_index;
 static GList *appid_map;
 static GList *appid_filter_list;
 static GList *title_filter_list;
+static GRegex *appid_filter;
+static GRegex *title_filter;
+static guint filter_serial = 1;
+static guint map_serial = 1;
 static gpointer wt_focus;
 static gboolean disown;
 
@@ -85,25 +92,54 @@ gint wintree_compare ( window_t *a, window_t *b)
   return GPOINTER_TO_INT(a->uid - b->uid);
 }
 
+static GList *wintree_link_from_id ( gpointer id )
+{
+  if(!wt_uid_index)
+    return NULL;
+  return g_hash_table_lookup(wt_uid_index, id);
+}
+
+static void wintree_pid_index_set ( gint64 pid, GList *list )
+{
+  if(!wt_pid_index)
+    wt_pid_index = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+        g_free, NULL);
+
+  if(list)
+    g_hash_table_insert(wt_pid_index, g_memdup2(&pid, sizeof(gint64)), list);
+  else
+    g_hash_table_remove(wt_pid_index, &pid);
+}
+
+static GList *wintree_pid_index_get ( gint64 pid )
+{
+  if(!wt_pid_index)
+    return NULL;
+  return g_hash_table_lookup(wt_pid_index, &pid);
+}
+
 void wintree_set_focus ( gpointer id )
 {
   GList *iter;
+  window_t *win;
 
   if(wt_focus == id)
     return;
   wintree_commit(wintree_from_id(wt_focus));
   wt_focus = id;
-  for(iter=wt_list; iter; iter=g_list_next(iter) )
-    if (((window_t *)(iter->data))->uid == id)
-      break;
+  iter = wintree_link_from_id(id);
   if(!iter)
     return;
   if(g_list_previous(iter))
   {
+    wt_tail = g_list_previous(iter);
     g_list_previous(iter)->next = NULL;
     iter->prev = NULL;
     wt_list = g_list_concat(iter, wt_list);
   }
+  win = iter->data;
+  wintree_pid_index_set(win->pid, g_list_prepend(
+        g_list_remove(wintree_pid_index_get(win->pid), win), win));
   wintree_commit(wt_list->data);
   g_idle_add((GSourceFunc)base_widget_emit_trigger,
       (gpointer)g_intern_static_string("window_focus"));
@@ -121,24 +157,18 @@ gboolean wintree_is_focused ( gpointer id )
 
 window_t *wintree_from_id ( gpointer id )
 {
-  GList *iter;
-
-  for(iter = wt_list; iter; iter=g_list_next(iter) )
-    if ( ((window_t *)(iter->data))->uid == id )
-      break;
+  GList *link;
 
-  return iter?iter->data:NULL;
+  link = wintree_link_from_id(id);
+  return link?link->data:NULL;
 }
 
 window_t *wintree_from_pid ( gint64 pid )
 {
-  GList *iter;
-
-  for(iter = wt_list; iter; iter=g_list_next(iter) )
-    if ( ((window_t *)(iter->data))->pid == pid )
-      break;
+  GList *list;
 
-  return iter?iter->data:NULL;
+  list = wintree_pid_index_get(pid);
+  return list?list->data:NULL;
 }
 
 void wintree_commit ( window_t *win )
@@ -150,42 +180,53 @@ void wintree_commit ( window_t *win )
   switcher_invalidate(win);
 }
 
-void wintree_set_title ( gpointer wid, const gchar *title )
+/* update the title without committing, for callers that batch changes */
+gboolean wintree_update_title ( window_t *win, const gchar *title )
 {
-  window_t *win;
-
-  if(!title)
-    return;
-
-  win = wintree_from_id(wid);
-  if(!win)
-    return;
-  if(!g_strcmp0(win->title,title))
-    return;
+  if(!win || !title || !g_strcmp0(win->title,title))
+    return FALSE;
 
   g_free(win->title);
   win->title = g_strdup(title);
-  wintree_commit(win);
+  win->filter_serial = 0;
+  win->map_serial = 0;
+
+  return TRUE;
 }
 
-void wintree_set_app_id ( gpointer wid, const gchar *app_id)
+void wintree_set_title ( gpointer wid, const gchar *title )
 {
   window_t *win;
 
-  if(!app_id)
-    return;
-
   win = wintree_from_id(wid);
-  if(!win || !g_strcmp0(win->appid, app_id))
-    return;
+  if(wintree_update_title(win, title))
+    wintree_commit(win);
+}
+
+gboolean wintree_update_app_id ( window_t *win, const gchar *app_id )
+{
+  if(!win || !app_id || !g_strcmp0(win->appid, app_id))
+    return FALSE;
+
   taskbar_destroy_item (win);
   g_free(win->appid);
   win->appid = g_strdup(app_id);
   if(!win->title)
     win->title = g_strdup(app_id);
+  win->filter_serial = 0;
+  win->map_serial = 0;
   taskbar_init_item (win);
 
-  wintree_commit(win);
+  return TRUE;
+}
+
+void wintree_set_app_id ( gpointer wid, const gchar *app_id)
+{
+  window_t *win;
+
+  win = wintree_from_id(wid);
+  if(wintree_update_app_id(win, app_id))
+    wintree_commit(win);
 }
 
 void wintree_set_workspace ( gpointer wid, gpointer wsid )
@@ -232,8 +273,19 @@ void wintree_window_append ( window_t *win )
   }
   if(win->title || win->appid)
     switcher_window_init(win);
-  if(g_list_find(wt_list, win)==NULL)
-    wt_list = g_list_append (wt_list, win);
+  if(!wt_uid_index)
+    wt_uid_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+  if(!wintree_link_from_id(win->uid))
+  {
+    /* keep a tail pointer so appending doesn't walk the list */
+    if(wt_tail)
+      wt_tail = g_list_next(g_list_append(wt_tail, win));
+    else
+      wt_list = wt_tail = g_list_append(NULL, win);
+    g_hash_table_insert(wt_uid_index, win->uid, wt_tail);
+    wintree_pid_index_set(win->pid,
+        g_list_append(wintree_pid_index_get(win->pid), win));
+  }
   wintree_commit(win);
 }
 
@@ -242,13 +294,16 @@ void wintree_window_delete ( gpointer id )
   GList *iter;
   window_t *win;
 
-  for(iter=wt_list; iter; iter=g_list_next(iter) )
-    if ( ((window_t *)(iter->data))->uid == id )
-      break;
+  iter = wintree_link_from_id(id);
   if(!iter || !iter->data)
     return;
   win = iter->data;
 
+  g_hash_table_remove(wt_uid_index, id);
+  wintree_pid_index_set(win->pid,
+      g_list_remove(wintree_pid_index_get(win->pid), win));
+  if(iter == wt_tail)
+    wt_tail = g_list_previous(iter);
   wt_list = g_list_delete_link(wt_list, iter);
   taskbar_destroy_item (win);
   switcher_window_delete(win);
@@ -286,63 +341,144 @@ void wintree_appid_map_add ( gchar *pattern, gchar *appid )
   }
   map->app_id = g_strdup(appid);
   appid_map = g_list_prepend(appid_map,map);
+  map_serial++;
 }
 
-gchar *wintree_appid_map_lookup ( gchar *title )
+/* the mapped app_id is cached in the window and only looked up again once
+ * the title changes or new mappings are added */
+gchar *wintree_appid_map_lookup ( window_t *win )
 {
   GList *iter;
 
-  for(iter=appid_map;iter;iter=g_list_next(iter))
-    if(g_regex_match (((struct appid_mapper *)iter->data)->regex,
-          title, 0, NULL))
-      return ((struct appid_mapper *)iter->data)->app_id;
-  return NULL;
+  if(!win)
+    return NULL;
+  if(win->map_serial == map_serial)
+    return win->mapped_appid;
+
+  win->mapped_appid = NULL;
+  win->map_serial = map_serial;
+  if(win->title)
+    for(iter=appid_map;iter;iter=g_list_next(iter))
+      if(g_regex_match (((struct appid_mapper *)iter->data)->regex,
+            win->title, 0, NULL))
+      {
+        win->mapped_appid = ((struct appid_mapper *)iter->data)->app_id;
+        break;
+      }
+  return win->mapped_appid;
 }
 
-void wintree_filter_appid ( gchar *pattern )
+/* combine all filter patterns into a single alternation, so a string can be
+ * checked against all of them in one pass. Patterns with back references
+ * can't be safely combined, in which case we match the list one by one */
+static GRegex *wintree_filter_combine ( GList *list )
 {
+  GString *str;
   GList *iter;
   GRegex *regex;
 
-  for(iter=appid_filter_list;iter;iter=g_list_next(iter))
-    if(!g_strcmp0(pattern,
-          g_regex_get_pattern(((struct appid_mapper *)iter->data)->regex)))
-      return;
+  str = g_string_new(NULL);
+  for(iter=list; iter; iter=g_list_next(iter))
+  {
+    if(g_regex_get_max_backref(iter->data))
+    {
+      g_string_free(str, TRUE);
+      return NULL;
+    }
+    g_string_append_printf(str, "%s(?:%s)", str->len?"|":"",
+        g_regex_get_pattern(iter->data));
+  }
 
-  regex = g_regex_new(pattern,0,0,NULL);
-  if(!regex)
-    return;
+  regex = g_regex_new(str->str, G_REGEX_OPTIMIZE, 0, NULL);
+  g_string_free(str, TRUE);
 
-  appid_filter_list = g_list_prepend(appid_filter_list, regex);
+  return regex;
 }
 
-void wintree_filter_title ( gchar *pattern )
+static gboolean wintree_filter_add ( GList **list, GRegex **combined,
+    gchar *pattern )
 {
   GList *iter;
   GRegex *regex;
 
-  for(iter=title_filter_list;iter;iter=g_list_next(iter))
-    if(!g_strcmp0(pattern,
-          g_regex_get_pattern(((struct appid_mapper *)iter->data)->regex)))
-      return;
+  for(iter=*list;iter;iter=g_list_next(iter))
+    if(!g_strcmp0(pattern, g_regex_get_pattern(iter->data)))
+      return FALSE;
 
   regex = g_regex_new(pattern,0,0,NULL);
   if(!regex)
-    return;
+    return FALSE;
+
+  *list = g_list_prepend(*list, regex);
+  g_clear_pointer(combined, g_regex_unref);
+  *combined = wintree_filter_combine(*list);
+  filter_serial++;
 
-  title_filter_list = g_list_prepend(title_filter_list, regex);
+  return TRUE;
+}
+
+void wintree_filter_appid ( gchar *pattern )
+{
+  wintree_filter_add(&appid_filter_list, &appid_filter, pattern);
+}
+
+void wintree_filter_title ( gchar *pattern )
+{
+  wintree_filter_add(&title_filter_list, &title_filter, pattern);
+}
+
+static gboolean wintree_filter_match ( GRegex *combined, GList *list,
+    gchar *string )
+{
+  if(!string)
+    return FALSE;
+  if(combined)
+    return g_regex_match(combined, string, 0, NULL);
+  return regex_match_list(list, string);
 }
 
 gboolean wintree_is_filtered ( window_t *win )
 {
-  return (regex_match_list(appid_filter_list, win->appid) ||
-    regex_match_list(title_filter_list, win->title));
+  if(win->filter_serial != filter_serial)
+  {
+    win->filtered =
+      wintree_filter_match(appid_filter, appid_filter_list, win->appid) ||
+      wintree_filter_match(title_filter, title_filter_list, win->title);
+    win->filter_serial = filter_serial;
+  }
+
+  return win->filtered;
 }
 
 static gint x_step, y_step, x_origin, y_origin;
 static gboolean check_pid;
 static gboolean placer;
 
+static void wintree_appid_mapper_free ( struct appid_mapper *map )
+{
+  g_regex_unref(map->regex);
+  g_free(map->app_id);
+  g_free(map);
+}
+
+/* drop app_id maps, filters and placer settings ahead of a config reload.
+ * Bumping the serials makes windows drop their cached results */
+void wintree_config_clear ( void )
+{
+  g_list_free_full(g_steal_pointer(&appid_map),
+      (GDestroyNotify)wintree_appid_mapper_free);
+  g_list_free_full(g_steal_pointer(&appid_filter_list),
+      (GDestroyNotify)g_regex_unref);
+  g_list_free_full(g_steal_pointer(&title_filter_list),
+      (GDestroyNotify)g_regex_unref);
+  g_clear_pointer(&appid_filter, g_regex_unref);
+  g_clear_pointer(&title_filter, g_regex_unref);
+  map_serial++;
+  filter_serial++;
+  placer = FALSE;
+  disown = FALSE;
+}
+
 void wintree_placer_conf( gint xs, gint ys, gint xo, gint yo, gboolean pid )
 {
   x_step = MAX(1,xs);
@@ -360,17 +496,10 @@ gboolean wintree_placer_state ( void )
 
 gboolean wintree_placer_check ( gint pid )
 {
-  GList *iter;
-  gint count = 0;
-
   if(!placer)
     return FALSE;
 
-  for(iter = wt_list; iter; iter = g_list_next(iter) )
-    if ( ((window_t *)(iter->data))->pid == pid )
-      count++;
-
-  return (count<2);
+  return (g_list_length(wintree_pid_index_get(pid))<2);
 }
 
 static int comp_int ( const void *x1, const void *x2)
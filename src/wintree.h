@@ -14,6 +14,10 @@ typedef struct wt_window {
   guint16 state;
   gboolean floating;
   gboolean valid;
+  gboolean filtered;
+  guint filter_serial;
+  gchar *mapped_appid;
+  guint map_serial;
 } window_t;
 
 struct wintree_api {
@@ -38,6 +42,8 @@ void wintree_set_focus ( gpointer id );
 void wintree_set_active ( gchar *title );
 void wintree_set_title ( gpointer wid, const gchar *title );
 void wintree_set_app_id ( gpointer wid, const gchar *app_id);
+gboolean wintree_update_title ( window_t *win, const gchar *title );
+gboolean wintree_update_app_id ( window_t *win, const gchar *app_id );
 void wintree_set_workspace ( gpointer wid, gpointer wsid );
 void wintree_set_float ( gpointer wid, gboolean floating );
 void wintree_focus ( gpointer id );
@@ -53,11 +59,12 @@ gboolean wintree_is_focused ( gpointer id );
 GList *wintree_get_list ( void );
 gint wintree_compare ( window_t *a, window_t *b);
 void wintree_appid_map_add ( gchar *pattern, gchar *appid );
-gchar *wintree_appid_map_lookup ( gchar *title );
+gchar *wintree_appid_map_lookup ( window_t *win );
 void wintree_filter_appid ( gchar *pattern );
 void wintree_filter_title ( gchar *pattern );
 gboolean wintree_is_filtered ( window_t *win );
 void wintree_placer_conf( gint xs, gint ys, gint xo, gint yo, gboolean pid );
+void wintree_config_clear ( void );
 gboolean wintree_placer_state ( void );
 gboolean wintree_placer_check ( gint pid );
 void wintree_placer_calc ( gint nobs, GdkRectangle *obs, GdkRectangle output,